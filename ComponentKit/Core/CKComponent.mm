@@ -27,6 +27,7 @@
 #import "CKComponentController.h"
 #import "CKComponentDebugController.h"
 #import "CKComponentLayout.h"
+#import "CKComponentLayoutReuse.h"
 #import "CKComponentScopeHandle.h"
 #import "CKComponentViewConfiguration.h"
 #import "CKInternalHelpers.h"
@@ -34,6 +35,8 @@
 #import "CKWeakObjectContainer.h"
 #import "ComponentLayoutContext.h"
 
+#include <algorithm>
+
 CGFloat const kCKComponentParentDimensionUndefined = NAN;
 CGSize const kCKComponentParentSizeUndefined = {kCKComponentParentDimensionUndefined, kCKComponentParentDimensionUndefined};
 
@@ -43,6 +46,59 @@ struct CKComponentMountInfo {
   CKComponentViewContext viewContext;
 };
 
+/** The most recent layouts of a component that opted in with +layoutCacheCapacity, most recently used first. */
+class CKComponentLayoutCache {
+public:
+  CKComponentLayoutCache(NSUInteger capacity) : _capacity(capacity) {}
+
+  bool find(CKComponent *component, const CKSizeRange &sizeRange, CGSize parentSize, CKComponentLayout &layout)
+  {
+    CK::MutexLocker l(_mutex);
+    for (auto it = _entries.begin(); it != _entries.end(); ++it) {
+      if (it->matches(sizeRange, parentSize)) {
+        layout = CKComponentLayout(component, it->size);
+        layout.children = it->children;
+        layout.extra = it->extra;
+        std::rotate(_entries.begin(), it, it + 1);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void insert(const CKSizeRange &sizeRange, CGSize parentSize, const CKComponentLayout &layout)
+  {
+    CK::MutexLocker l(_mutex);
+    _entries.insert(_entries.begin(), {sizeRange, parentSize, layout.size, layout.children, layout.extra});
+    if (_entries.size() > _capacity) {
+      _entries.pop_back();
+    }
+  }
+
+private:
+  struct Entry {
+    CKSizeRange sizeRange;
+    CGSize parentSize;
+    // Everything but the component: the cache is owned by the component, so keeping it would create a retain cycle.
+    CGSize size;
+    std::shared_ptr<const std::vector<CKComponentLayoutChild>> children;
+    NSDictionary *extra;
+
+    bool matches(const CKSizeRange &otherSizeRange, CGSize otherParentSize) const
+    {
+      // Undefined parent dimensions are NAN, which never compares equal to itself
+      auto equal = [](CGFloat a, CGFloat b) { return a == b || (isnan(a) && isnan(b)); };
+      return sizeRange == otherSizeRange
+      && equal(parentSize.width, otherParentSize.width)
+      && equal(parentSize.height, otherParentSize.height);
+    }
+  };
+
+  CK::Mutex _mutex;
+  const NSUInteger _capacity;
+  std::vector<Entry> _entries;
+};
+
 @implementation CKComponent
 {
   CKComponentScopeHandle<CKComponentController *> *_scopeHandle;
@@ -50,6 +106,9 @@ struct CKComponentMountInfo {
 
   /** Only non-null while mounted. */
   std::unique_ptr<CKComponentMountInfo> _mountInfo;
+
+  /** Only non-null if the class opted in with +layoutCacheCapacity. */
+  std::unique_ptr<CKComponentLayoutCache> _layoutCache;
 }
 
 #if DEBUG
@@ -85,6 +144,10 @@ struct CKComponentMountInfo {
     _scopeHandle = [CKComponentScopeHandle handleForComponent:self];
     _viewConfiguration = view;
     _size = size;
+    const NSUInteger layoutCacheCapacity = [[self class] layoutCacheCapacity];
+    if (layoutCacheCapacity > 0) {
+      _layoutCache.reset(new CKComponentLayoutCache(layoutCacheCapacity));
+    }
   }
   return self;
 }
@@ -223,6 +286,17 @@ struct CKComponentMountInfo {
 
 - (CKComponentLayout)layoutThatFits:(CKSizeRange)constrainedSize parentSize:(CGSize)parentSize
 {
+  CKComponentLayout previousLayout;
+  if (CKReusePreviousComponentLayout(self, constrainedSize, parentSize, previousLayout)) {
+    return previousLayout;
+  }
+
+  CKComponentLayout cachedLayout;
+  if (_layoutCache && _layoutCache->find(self, constrainedSize, parentSize, cachedLayout)) {
+    CKRecordComponentLayoutForReuse(self, constrainedSize, parentSize, cachedLayout);
+    return cachedLayout;
+  }
+
   CK::Component::LayoutContext context(self, constrainedSize);
 
   CKComponentLayout layout = [self computeLayoutThatFits:constrainedSize
@@ -239,9 +313,18 @@ struct CKComponentMountInfo {
            @"Computed size %@ for %@ does not fall within constrained size %@\n%@",
            NSStringFromCGSize(layout.size), [self class], resolvedRange.description(),
            CK::Component::LayoutContext::currentStackDescription());
+  if (_layoutCache) {
+    _layoutCache->insert(constrainedSize, parentSize, layout);
+  }
+  CKRecordComponentLayoutForReuse(self, constrainedSize, parentSize, layout);
   return layout;
 }
 
++ (NSUInteger)layoutCacheCapacity
+{
+  return 0;
+}
+
 - (CKComponentLayout)computeLayoutThatFits:(CKSizeRange)constrainedSize
                           restrictedToSize:(const CKComponentSize &)size
                       relativeToParentSize:(CGSize)parentSize
@@ -15,6 +15,7 @@
 #import <CoreGraphics/CoreGraphics.h>
 #import <UIKit/UIKit.h>
 
+#import "ComponentLayoutContext.h"
 #import "ComponentUtilities.h"
 #import "CKComponentInternal.h"
 #import "CKComponentSubclass.h"
@@ -107,7 +108,11 @@ NSSet *CKMountComponentLayout(const CKComponentLayout &layout,
 
 CKComponentLayout CKComputeRootComponentLayout(CKComponent *rootComponent, const CKSizeRange &sizeRange)
 {
-  const CKComponentLayout layout = CKComputeComponentLayout(rootComponent, sizeRange, sizeRange.max);
+  CKComponentLayout layout;
+  {
+    CK::Component::LayoutPass pass;
+    layout = CKComputeComponentLayout(rootComponent, sizeRange, sizeRange.max);
+  }
   CKDetectComponentScopeCollisions(layout);
   return layout;
 }
@@ -0,0 +1,75 @@
+/*
+ *  Copyright (c) 2014-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+
+#import <Foundation/Foundation.h>
+
+#import <ComponentKit/CKComponentLayout.h>
+#import <ComponentKit/CKSizeRange.h>
+
+@class CKComponent;
+
+/**
+ Lets a layout pass reuse the layouts computed by the previous one.
+
+ After a state update, only the components on the path from the root to the updated component are rebuilt; the rest of
+ the tree is the same component instances as before (e.g. they were memoized with CKMemoize). When one of those
+ components is laid out with the same size range and parent size as in the previous pass, its previous layout is
+ returned as is, without laying out its subtree again. The entries of its subtree aren't copied into the new state
+ either: the new state looks them up in the previous one when a later pass needs them. That makes re-laying out a tree
+ after a small change cost roughly the size of the rebuilt path instead of the size of the tree, except that every
+ eighth pass in a row that reuses layouts copies the entries of the reused subtrees into its own state so that it can
+ let go of the previous ones; amortized, that is the size of the tree divided by eight per pass.
+
+ Put one in scope around the layout pass, and store its state for the next one:
+
+ {
+   CKComponentLayoutReuse reuse(_layoutReuseState);
+   layout = CKComputeRootComponentLayout(result.component, sizeRange);
+   _layoutReuseState = reuse.nextState();
+ }
+
+ This relies on a component's layout depending only on the component itself, its children and the constraints it is
+ laid out with, which is the case for components since they are immutable.
+
+ A state costs one hash table entry per component and size range laid out or reused in the pass, about a hundred bytes,
+ and keeps up to seven previous states alive until it copies what it needs from them. The layouts it records share
+ their children with the layout tree they are part of, so the states mostly keep alive what the layout they were
+ stored with already does, plus the layouts of components that were rebuilt or only measured since (e.g. flexbox
+ children measured with several size ranges).
+ */
+struct CKComponentLayoutReuse {
+
+  /** Makes the layouts recorded in previousState available to layouts computed on this thread while in scope. */
+  CKComponentLayoutReuse(id previousState);
+
+  ~CKComponentLayoutReuse();
+
+  /** The layouts computed or reused while in scope. Pass it to the CKComponentLayoutReuse of the next layout pass. */
+  id nextState();
+
+private:
+  id outerState_;
+  id state_;
+};
+
+/**
+ Used by -[CKComponent layoutThatFits:parentSize:]. If a CKComponentLayoutReuse is in scope and the component was laid
+ out with the same constraints by the previous pass, sets layout to the previous layout and returns YES.
+ */
+BOOL CKReusePreviousComponentLayout(CKComponent *component,
+                                    const CKSizeRange &constrainedSize,
+                                    CGSize parentSize,
+                                    CKComponentLayout &layout);
+
+/** Used by -[CKComponent layoutThatFits:parentSize:] to record a layout it computed for the next pass. */
+void CKRecordComponentLayoutForReuse(CKComponent *component,
+                                     const CKSizeRange &constrainedSize,
+                                     CGSize parentSize,
+                                     const CKComponentLayout &layout);
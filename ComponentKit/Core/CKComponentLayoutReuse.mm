@@ -0,0 +1,190 @@
+/*
+ *  Copyright (c) 2014-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+
+#import "CKComponentLayoutReuse.h"
+
+#import <pthread.h>
+#import <unordered_map>
+#import <vector>
+
+struct CKComponentLayoutReuseEntry {
+  CKSizeRange sizeRange;
+  CGSize parentSize;
+  CKComponentLayout layout;
+
+  bool matches(const CKSizeRange &otherSizeRange, CGSize otherParentSize) const
+  {
+    // Undefined parent dimensions are NAN, which never compares equal to itself
+    auto equal = [](CGFloat a, CGFloat b) { return a == b || (isnan(a) && isnan(b)); };
+    return sizeRange == otherSizeRange
+    && equal(parentSize.width, otherParentSize.width)
+    && equal(parentSize.height, otherParentSize.height);
+  }
+};
+
+// Keyed by component pointer; the entries' layouts keep the components alive. A multimap rather than a map of vectors
+// so that each entry costs a single allocation; most components are laid out with a single size range.
+typedef std::unordered_multimap<const void *, CKComponentLayoutReuseEntry> CKComponentLayoutReuseMap;
+
+/** After this many passes in a row that reuse layouts, a state copies the entries it reaches through its previous ones. */
+static const NSUInteger kMaximumStateDepth = 8;
+
+@interface _CKComponentLayoutReuseState : NSObject {
+  @package
+  // Layouts computed or reused by the pass this state belongs to, for the next pass
+  CKComponentLayoutReuseMap _layouts;
+  // The descendants of the layouts reused by this pass aren't copied to _layouts; they are looked up here instead.
+  // Only kept after the pass if it reused a layout.
+  _CKComponentLayoutReuseState *_previous;
+  // The number of states reachable through _previous, including this one
+  NSUInteger _depth;
+  // Only set while the pass is in progress, for compacting the state at the end of it
+  std::vector<CKComponentLayout> _reusedLayouts;
+}
+@end
+
+@implementation _CKComponentLayoutReuseState
+@end
+
+static pthread_key_t kCKComponentLayoutReuseThreadKey;
+
+static _CKComponentLayoutReuseState *currentState()
+{
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    pthread_key_create(&kCKComponentLayoutReuseThreadKey, nullptr);
+  });
+  return (__bridge _CKComponentLayoutReuseState *)pthread_getspecific(kCKComponentLayoutReuseThreadKey);
+}
+
+static void setCurrentState(_CKComponentLayoutReuseState *state)
+{
+  // currentState() creates the key
+  (void)currentState();
+  pthread_setspecific(kCKComponentLayoutReuseThreadKey, (__bridge const void *)state);
+}
+
+static void addEntry(CKComponentLayoutReuseMap &layouts, const void *key, const CKComponentLayoutReuseEntry &entry)
+{
+  const auto range = layouts.equal_range(key);
+  for (auto it = range.first; it != range.second; ++it) {
+    if (it->second.matches(entry.sizeRange, entry.parentSize)) {
+      it->second = entry;
+      return;
+    }
+  }
+  layouts.emplace(key, entry);
+}
+
+/** Returns the entry of the component laid out with the given constraints in state or the states it falls back to. */
+static const CKComponentLayoutReuseEntry *findEntry(_CKComponentLayoutReuseState *state,
+                                                    const void *key,
+                                                    const CKSizeRange &constrainedSize,
+                                                    CGSize parentSize)
+{
+  for (; state != nil; state = state->_previous) {
+    const auto range = state->_layouts.equal_range(key);
+    for (auto it = range.first; it != range.second; ++it) {
+      if (it->second.matches(constrainedSize, parentSize)) {
+        return &it->second;
+      }
+    }
+  }
+  return nullptr;
+}
+
+/** Copies the entries of the descendants of a reused layout found through previous, so previous can be released. */
+static void copyDescendants(const CKComponentLayout &layout,
+                            _CKComponentLayoutReuseState *previous,
+                            CKComponentLayoutReuseMap &layouts)
+{
+  if (!layout.children) {
+    return;
+  }
+  for (const auto &child : *layout.children) {
+    const void *key = (__bridge const void *)child.layout.component;
+    if (layouts.find(key) == layouts.end()) {
+      for (_CKComponentLayoutReuseState *state = previous; state != nil; state = state->_previous) {
+        const auto range = state->_layouts.equal_range(key);
+        if (range.first != range.second) {
+          layouts.insert(range.first, range.second);
+          break;
+        }
+      }
+    }
+    copyDescendants(child.layout, previous, layouts);
+  }
+}
+
+CKComponentLayoutReuse::CKComponentLayoutReuse(id previousState)
+{
+  _CKComponentLayoutReuseState *state = [[_CKComponentLayoutReuseState alloc] init];
+  _CKComponentLayoutReuseState *previous = previousState;
+  state->_previous = previous;
+  state->_depth = previous ? previous->_depth + 1 : 1;
+  state_ = state;
+  outerState_ = currentState();
+  setCurrentState(state);
+}
+
+CKComponentLayoutReuse::~CKComponentLayoutReuse()
+{
+  setCurrentState(outerState_);
+  _CKComponentLayoutReuseState *state = state_;
+  if (state->_reusedLayouts.empty()) {
+    // Every layout is in _layouts; don't keep the previous passes alive
+    state->_previous = nil;
+    state->_depth = 1;
+  } else if (state->_depth > kMaximumStateDepth) {
+    for (const auto &layout : state->_reusedLayouts) {
+      copyDescendants(layout, state->_previous, state->_layouts);
+    }
+    state->_previous = nil;
+    state->_depth = 1;
+  }
+  state->_reusedLayouts.clear();
+  state->_reusedLayouts.shrink_to_fit();
+}
+
+id CKComponentLayoutReuse::nextState()
+{
+  return state_;
+}
+
+BOOL CKReusePreviousComponentLayout(CKComponent *component,
+                                    const CKSizeRange &constrainedSize,
+                                    CGSize parentSize,
+                                    CKComponentLayout &layout)
+{
+  _CKComponentLayoutReuseState *state = currentState();
+  if (state == nil || state->_previous == nil) {
+    return NO;
+  }
+  const void *key = (__bridge const void *)component;
+  const CKComponentLayoutReuseEntry *entry = findEntry(state->_previous, key, constrainedSize, parentSize);
+  if (entry == nullptr) {
+    return NO;
+  }
+  layout = entry->layout;
+  addEntry(state->_layouts, key, *entry);
+  state->_reusedLayouts.push_back(entry->layout);
+  return YES;
+}
+
+void CKRecordComponentLayoutForReuse(CKComponent *component,
+                                     const CKSizeRange &constrainedSize,
+                                     CGSize parentSize,
+                                     const CKComponentLayout &layout)
+{
+  _CKComponentLayoutReuseState *state = currentState();
+  if (state != nil) {
+    addEntry(state->_layouts, (__bridge const void *)component, {constrainedSize, parentSize, layout});
+  }
+}
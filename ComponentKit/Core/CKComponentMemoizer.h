@@ -94,10 +94,19 @@ struct CKComponentMemoizer {
 
   /**
    Store this state across rebuilding components.
-   Do not use this object from multiple threads simultaneously
+   A CKComponentMemoizer belongs to the thread that created it, since it is what CKMemoize() finds in scope there, and
+   must be destroyed on that thread. The states it vends are locked internally: several threads may vend from and
+   memoize into the same state at once, e.g. by passing currentMemoizerState() to a memoizer on each of them.
    */
   id nextMemoizerState();
 
+  /**
+   Returns the memoizer state in scope on the calling thread, or nil if there is none. Pass it to a CKComponentMemoizer
+   on another thread to make memoized layouts available to work done there on behalf of this thread; the state may be
+   shared by several threads at once while laying out.
+   */
+  static id currentMemoizerState();
+
 private:
   id previousMemoizer_;
 };
@@ -14,6 +14,7 @@
 #import "CKComponentSubclass.h"
 #import "CKMacros.h"
 #import "CKInternalHelpers.h"
+#import "CKMutex.h"
 
 #include <map>
 
@@ -67,6 +68,9 @@ struct CKLayoutMemoizationKey {
   std::unordered_multimap<CKMemoizationKey, CKComponent *> componentCache_;
 
   std::unordered_map<CKLayoutMemoizationKey, CKComponentLayout, CKLayoutMemoizationKey::Hash, CKLayoutMemoizationKey::Equals> layoutCache_;
+
+  // Guards _next and the caches above, since layout may be memoized from several threads at once
+  CK::Mutex _mutex;
 }
 
 @end
@@ -76,6 +80,7 @@ struct CKLayoutMemoizationKey {
 
 - (CKComponent *)dequeueComponentForKey:(CKMemoizationKey)key
 {
+  CK::MutexLocker l(_mutex);
   auto it = componentCache_.find(key);
   if (it != componentCache_.end()) {
     CKComponent *c = it->second;
@@ -88,6 +93,7 @@ struct CKLayoutMemoizationKey {
 
 - (_CKComponentMemoizerImpl *)next
 {
+  CK::MutexLocker l(_mutex);
   if (!_next) {
     _next = [[_CKComponentMemoizerImpl alloc] init];
   }
@@ -96,7 +102,30 @@ struct CKLayoutMemoizationKey {
 
 - (void)enqueueComponent:(CKComponent *)component forKey:(CKMemoizationKey)key
 {
-  self.next->componentCache_.insert({key, component});
+  [self.next insertComponent:component forKey:key];
+}
+
+- (void)insertComponent:(CKComponent *)component forKey:(CKMemoizationKey)key
+{
+  CK::MutexLocker l(_mutex);
+  componentCache_.insert({key, component});
+}
+
+- (void)insertLayout:(const CKComponentLayout &)layout forKey:(const CKLayoutMemoizationKey &)key
+{
+  CK::MutexLocker l(_mutex);
+  layoutCache_.insert({key, layout});
+}
+
+- (BOOL)getLayout:(CKComponentLayout *)layout forKey:(const CKLayoutMemoizationKey &)key
+{
+  CK::MutexLocker l(_mutex);
+  auto it = layoutCache_.find(key);
+  if (it == layoutCache_.end()) {
+    return NO;
+  }
+  *layout = it->second;
+  return YES;
 }
 
 - (CKComponentLayout)cachedLayout:(CKComponent *)component
@@ -106,15 +135,13 @@ struct CKLayoutMemoizationKey {
                             block:(CKComponentLayout (^)())block
 {
   CKLayoutMemoizationKey key{.component = component, .thatFits = constrainedSize, .parentSize = parentSize};
-  auto it = layoutCache_.find(key);
-  if (it != layoutCache_.end()) {
-    self.next->layoutCache_.insert({key, it->second});
-    return it->second;
-  } else {
-    CKComponentLayout layout = block();
-    self.next->layoutCache_.insert({key, layout});
-    return layout;
+  CKComponentLayout layout;
+  // The block is called without holding any lock, since it may memoize the layout of its own children
+  if (![self getLayout:&layout forKey:key]) {
+    layout = block();
   }
+  [self.next insertLayout:layout forKey:key];
+  return layout;
 }
 
 + (_CKComponentMemoizerImpl *)currentMemoizer
@@ -165,6 +192,11 @@ id CKMemoize(CKMemoizationKey memoizationKey, id (^block)(void))
   return component;
 }
 
+id CKComponentMemoizer::currentMemoizerState()
+{
+  return [_CKComponentMemoizerImpl currentMemoizer];
+}
+
 id CKComponentMemoizer::nextMemoizerState()
 {
   _CKComponentMemoizerImpl *impl = [_CKComponentMemoizerImpl currentMemoizer];
@@ -78,6 +78,17 @@ extern CGSize const kCKComponentParentSizeUndefined;
                           restrictedToSize:(const CKComponentSize &)size
                       relativeToParentSize:(CGSize)parentSize;
 
+/**
+ Override this method to return the number of layouts each instance of your component should remember. When the
+ component is asked for a layout with a size range and parent size it has recently been laid out with (e.g. measured by
+ -sizeThatFits: and then laid out again in -layoutSubviews), the remembered layout is returned without calling
+ -computeLayoutThatFits: again. The default implementation returns 0, which disables the cache.
+
+ @warning Only opt in if your layout depends on nothing but the component itself, its children and the two parameters,
+ which is the case for most components since they are immutable.
+ */
++ (NSUInteger)layoutCacheCapacity;
+
 /**
  Enqueue a change to the state.
 
@@ -8,6 +8,8 @@
  *
  */
 
+#import <QuartzCore/QuartzCore.h>
+
 #import <ComponentKit/CKSizeRange.h>
 
 #import <vector>
@@ -21,6 +23,30 @@ namespace CK {
     /** A stack of layout contexts. */
     typedef std::vector<LayoutContext *> LayoutContextStack;
 
+    /**
+     Receives a callback whenever a component starts and finishes computing its layout, for profiling. Install one with
+     LayoutContext::setListener(); there is none by default, and layout only pays for checking that.
+
+     Callbacks are made on the thread performing layout, which may be a background thread and may be several threads at
+     once, so implementations must be thread-safe.
+     */
+    struct LayoutListener {
+      virtual ~LayoutListener() {}
+
+      /** Called before the component computes its layout. */
+      virtual void layoutWillStart(Class componentClass, const CKSizeRange &sizeRange) = 0;
+
+      /**
+       Called once the component has computed its layout.
+       @param inclusiveTime The wall time spent in the component's layout, including the layout of its children.
+       @param exclusiveTime The same, minus the wall time spent in the layout of its children on the same thread.
+       */
+      virtual void layoutDidEnd(Class componentClass,
+                                const CKSizeRange &sizeRange,
+                                CFTimeInterval inclusiveTime,
+                                CFTimeInterval exclusiveTime) = 0;
+    };
+
     /**
      Keeps track of the stack of components performing layout.
 
@@ -57,8 +83,69 @@ namespace CK {
        */
       static NSString *currentStackDescription();
 
+      /**
+       Sets the listener notified of every layout that starts from now on, or removes it if nil. The listener is not
+       retained and must outlive any layout it was set for.
+       */
+      static void setListener(LayoutListener *listener);
+
       LayoutContext(const LayoutContext&) = delete;
       LayoutContext &operator=(const LayoutContext&) = delete;
+
+    private:
+      /** Only set if there was a listener when the context was created; the fields below are unused otherwise. */
+      LayoutListener *const _listener;
+      /** The enclosing profiled context on the same thread, which the inclusive time is subtracted from. */
+      LayoutContext *_profiledParent;
+      CFTimeInterval _startTime;
+      CFTimeInterval _childrenTime;
+    };
+
+    /**
+     Used when a component hands part of its layout to other threads (e.g. parallel child measurement). Constructing
+     this class on a worker seeds that thread's stack with a copy of the stack taken on the thread that started the
+     work, so the worker's currentStack() still describes the full chain of components performing layout.
+
+     Does nothing if the current thread is already performing layout, which is the case when the starting thread runs
+     some of the work itself.
+     */
+    struct InheritedLayoutContextStack {
+      InheritedLayoutContextStack(const LayoutContextStack &stack);
+      /** Removes the inherited contexts. It is an error if any context pushed since has not been popped. */
+      ~InheritedLayoutContextStack();
+
+      InheritedLayoutContextStack(const InheritedLayoutContextStack&) = delete;
+      InheritedLayoutContextStack &operator=(const InheritedLayoutContextStack&) = delete;
+
+    private:
+      size_t _inheritedCount;
+    };
+
+    /**
+     Scopes the layout of a whole tree, e.g. by CKComputeRootComponentLayout. A component can keep state around that only
+     speeds up laying it out again during the same pass (e.g. when its parent measures it and then lays it out), and
+     have the pass release it when it ends, instead of keeping it for as long as the component lives.
+
+     Passes are per thread; threads that lay out part of a tree for another one (e.g. parallel child measurement) are
+     not in its pass.
+     */
+    struct LayoutPass {
+      LayoutPass();
+      /** Runs the blocks added while this was the innermost pass on the thread, in the order they were added. */
+      ~LayoutPass();
+
+      /** Whether a pass is in progress on this thread. */
+      static bool isInProgress();
+
+      /** Runs the block when the innermost pass in progress on this thread ends. There must be one. */
+      static void addCompletion(dispatch_block_t block);
+
+      LayoutPass(const LayoutPass&) = delete;
+      LayoutPass &operator=(const LayoutPass&) = delete;
+
+    private:
+      LayoutPass *_outerPass;
+      std::vector<dispatch_block_t> _completions;
     };
   }
 }
@@ -10,6 +10,7 @@
 
 #import "ComponentLayoutContext.h"
 
+#import <atomic>
 #import <pthread.h>
 #import <stack>
 
@@ -36,6 +37,27 @@ static LayoutContextStack &componentStack()
   return *contexts;
 }
 
+static std::atomic<LayoutListener *> currentListener(nullptr);
+
+static pthread_key_t kCKComponentProfiledLayoutContextThreadKey;
+
+/** The innermost context created with a listener on this thread; unlike the stack, it is never inherited. */
+static LayoutContext *currentProfiledContext()
+{
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    pthread_key_create(&kCKComponentProfiledLayoutContextThreadKey, nullptr);
+  });
+  return static_cast<LayoutContext *>(pthread_getspecific(kCKComponentProfiledLayoutContextThreadKey));
+}
+
+static void setCurrentProfiledContext(LayoutContext *context)
+{
+  // currentProfiledContext() creates the key
+  (void)currentProfiledContext();
+  pthread_setspecific(kCKComponentProfiledLayoutContextThreadKey, context);
+}
+
 static void removeComponentStackForThisThread()
 {
   LayoutContextStack *contexts = static_cast<LayoutContextStack *>(pthread_getspecific(kCKComponentLayoutContextThreadKey));
@@ -43,14 +65,29 @@ static void removeComponentStackForThisThread()
   pthread_setspecific(kCKComponentLayoutContextThreadKey, nullptr);
 }
 
-LayoutContext::LayoutContext(CKComponent *c, CKSizeRange r) : component(c), sizeRange(r)
+LayoutContext::LayoutContext(CKComponent *c, CKSizeRange r)
+: component(c), sizeRange(r), _listener(currentListener.load()), _profiledParent(nullptr), _startTime(0), _childrenTime(0)
 {
   auto &stack = componentStack();
   stack.push_back(this);
+  if (_listener) {
+    _profiledParent = currentProfiledContext();
+    setCurrentProfiledContext(this);
+    _listener->layoutWillStart([component class], sizeRange);
+    _startTime = CACurrentMediaTime();
+  }
 }
 
 LayoutContext::~LayoutContext()
 {
+  if (_listener) {
+    const CFTimeInterval inclusiveTime = CACurrentMediaTime() - _startTime;
+    setCurrentProfiledContext(_profiledParent);
+    if (_profiledParent) {
+      _profiledParent->_childrenTime += inclusiveTime;
+    }
+    _listener->layoutDidEnd([component class], sizeRange, inclusiveTime, inclusiveTime - _childrenTime);
+  }
   auto &stack = componentStack();
   CKCAssert(stack.back() == this,
             @"Last component layout context %@ is not %@", stack.back()->component, component);
@@ -60,6 +97,31 @@ LayoutContext::~LayoutContext()
   }
 }
 
+InheritedLayoutContextStack::InheritedLayoutContextStack(const LayoutContextStack &stack) : _inheritedCount(0)
+{
+  auto &currentStack = componentStack();
+  if (currentStack.empty()) {
+    currentStack = stack;
+    _inheritedCount = stack.size();
+  }
+}
+
+InheritedLayoutContextStack::~InheritedLayoutContextStack()
+{
+  if (_inheritedCount == 0) {
+    return;
+  }
+  auto &stack = componentStack();
+  CKCAssert(stack.size() == _inheritedCount,
+            @"Layout contexts were not popped before leaving an inherited stack: %@", LayoutContext::currentStackDescription());
+  removeComponentStackForThisThread();
+}
+
+void LayoutContext::setListener(LayoutListener *listener)
+{
+  currentListener.store(listener);
+}
+
 const CK::Component::LayoutContextStack &LayoutContext::currentStack()
 {
   return componentStack();
@@ -82,3 +144,49 @@ NSString *LayoutContext::currentStackDescription()
   }
   return s;
 }
+
+static pthread_key_t kCKComponentLayoutPassThreadKey;
+
+static LayoutPass *currentLayoutPass()
+{
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    pthread_key_create(&kCKComponentLayoutPassThreadKey, nullptr);
+  });
+  return static_cast<LayoutPass *>(pthread_getspecific(kCKComponentLayoutPassThreadKey));
+}
+
+static void setCurrentLayoutPass(LayoutPass *pass)
+{
+  // currentLayoutPass() creates the key
+  (void)currentLayoutPass();
+  pthread_setspecific(kCKComponentLayoutPassThreadKey, pass);
+}
+
+LayoutPass::LayoutPass() : _outerPass(currentLayoutPass())
+{
+  setCurrentLayoutPass(this);
+}
+
+LayoutPass::~LayoutPass()
+{
+  CKCAssert(currentLayoutPass() == this, @"Layout passes must end in the reverse order they started");
+  setCurrentLayoutPass(_outerPass);
+  for (dispatch_block_t block : _completions) {
+    block();
+  }
+}
+
+bool LayoutPass::isInProgress()
+{
+  return currentLayoutPass() != nullptr;
+}
+
+void LayoutPass::addCompletion(dispatch_block_t block)
+{
+  LayoutPass *pass = currentLayoutPass();
+  CKCAssert(pass != nullptr, @"No layout pass in progress");
+  if (pass) {
+    pass->_completions.push_back(block);
+  }
+}
@@ -0,0 +1,71 @@
+/*
+ *  Copyright (c) 2014-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+
+#import <Foundation/Foundation.h>
+
+#import <ComponentKit/CKMutex.h>
+#import <ComponentKit/ComponentLayoutContext.h>
+
+#import <array>
+#import <unordered_map>
+#import <vector>
+
+namespace CK {
+  namespace Component {
+    /**
+     The number of buckets of LayoutClassStatistics::exclusiveTimeHistogram. Bucket 0 counts layouts that took less than
+     a microsecond, bucket i layouts that took from 2^(i-1) up to 2^i microseconds, and the last bucket all longer ones.
+     */
+    static const size_t kLayoutHistogramBucketCount = 20;
+
+    /** The layout times of all the components of one class, aggregated by a LayoutProfiler. */
+    struct LayoutClassStatistics {
+      Class componentClass;
+      /** The number of layouts computed by components of the class. */
+      NSUInteger count;
+      /** The sums of the inclusive and exclusive times of those layouts, in seconds. */
+      CFTimeInterval inclusiveTime;
+      CFTimeInterval exclusiveTime;
+      /** The distribution of the exclusive time of those layouts; see kLayoutHistogramBucketCount. */
+      std::array<NSUInteger, kLayoutHistogramBucketCount> exclusiveTimeHistogram;
+    };
+
+    /**
+     A layout listener that aggregates layout times per component class, to find out which classes dominate layout.
+
+       static CK::Component::LayoutProfiler profiler;
+       CK::Component::LayoutContext::setListener(&profiler);
+       ...
+       NSLog(@"%@", profiler.description());
+     */
+    class LayoutProfiler : public LayoutListener {
+    public:
+      void layoutWillStart(Class componentClass, const CKSizeRange &sizeRange) override {}
+      void layoutDidEnd(Class componentClass,
+                        const CKSizeRange &sizeRange,
+                        CFTimeInterval inclusiveTime,
+                        CFTimeInterval exclusiveTime) override;
+
+      /** The statistics of every class laid out so far, the classes with the largest total exclusive time first. */
+      std::vector<LayoutClassStatistics> statistics() const;
+
+      /** One line per class with the same statistics, in the same order. */
+      NSString *description() const;
+
+      /** Forgets everything aggregated so far. */
+      void reset();
+
+    private:
+      mutable CK::Mutex _mutex;
+      // Keyed by class pointer; classes are never deallocated
+      std::unordered_map<const void *, LayoutClassStatistics> _statistics;
+    };
+  }
+}
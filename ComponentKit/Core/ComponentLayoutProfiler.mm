@@ -0,0 +1,84 @@
+/*
+ *  Copyright (c) 2014-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+
+#import "ComponentLayoutProfiler.h"
+
+#import <algorithm>
+#import <cmath>
+
+using namespace CK::Component;
+
+static size_t histogramBucket(CFTimeInterval time)
+{
+  const CFTimeInterval microseconds = time * 1e6;
+  if (microseconds < 1) {
+    return 0;
+  }
+  const size_t bucket = static_cast<size_t>(std::floor(std::log2(microseconds))) + 1;
+  return std::min(bucket, kLayoutHistogramBucketCount - 1);
+}
+
+void LayoutProfiler::layoutDidEnd(Class componentClass,
+                                  const CKSizeRange &sizeRange,
+                                  CFTimeInterval inclusiveTime,
+                                  CFTimeInterval exclusiveTime)
+{
+  CK::MutexLocker l(_mutex);
+  auto it = _statistics.find((__bridge const void *)componentClass);
+  if (it == _statistics.end()) {
+    it = _statistics.insert({(__bridge const void *)componentClass, {componentClass, 0, 0, 0, {}}}).first;
+  }
+  LayoutClassStatistics &statistics = it->second;
+  statistics.count++;
+  statistics.inclusiveTime += inclusiveTime;
+  statistics.exclusiveTime += exclusiveTime;
+  statistics.exclusiveTimeHistogram[histogramBucket(exclusiveTime)]++;
+}
+
+std::vector<LayoutClassStatistics> LayoutProfiler::statistics() const
+{
+  std::vector<LayoutClassStatistics> statistics;
+  {
+    CK::MutexLocker l(_mutex);
+    statistics.reserve(_statistics.size());
+    for (const auto &entry : _statistics) {
+      statistics.push_back(entry.second);
+    }
+  }
+  std::sort(statistics.begin(), statistics.end(), [](const LayoutClassStatistics &a, const LayoutClassStatistics &b) {
+    return a.exclusiveTime > b.exclusiveTime;
+  });
+  return statistics;
+}
+
+NSString *LayoutProfiler::description() const
+{
+  NSMutableString *s = [NSMutableString string];
+  for (const auto &statistics : this->statistics()) {
+    if (s.length > 0) {
+      [s appendString:@"\n"];
+    }
+    [s appendFormat:@"%@: %lu layouts, %.3fms exclusive, %.3fms inclusive, histogram (us):",
+     NSStringFromClass(statistics.componentClass), (unsigned long)statistics.count,
+     statistics.exclusiveTime * 1000, statistics.inclusiveTime * 1000];
+    for (size_t i = 0; i < kLayoutHistogramBucketCount; i++) {
+      if (statistics.exclusiveTimeHistogram[i] > 0) {
+        [s appendFormat:@" <%lu:%lu", (unsigned long)(1ul << i), (unsigned long)statistics.exclusiveTimeHistogram[i]];
+      }
+    }
+  }
+  return s;
+}
+
+void LayoutProfiler::reset()
+{
+  CK::MutexLocker l(_mutex);
+  _statistics.clear();
+}
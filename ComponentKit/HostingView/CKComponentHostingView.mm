@@ -19,6 +19,7 @@
 #import "CKComponentDebugController.h"
 #import "CKComponentHostingViewDelegate.h"
 #import "CKComponentLayout.h"
+#import "CKComponentLayoutReuse.h"
 #import "CKComponentRootView.h"
 #import "CKComponentScopeRoot.h"
 #import "CKComponentScopeRootFactory.h"
@@ -52,6 +53,8 @@ struct CKComponentHostingViewInputs {
 
   CKComponentLayout _mountedLayout;
   NSSet *_mountedComponents;
+  /** Lets the layout of a rebuilt component reuse the parts of _mountedLayout that did not change. */
+  id _layoutReuseState;
 
   BOOL _scheduledAsynchronousComponentUpdate;
   BOOL _isSynchronouslyUpdatingComponent;
@@ -123,7 +126,9 @@ struct CKComponentHostingViewInputs {
     [self _synchronouslyUpdateComponentIfNeeded];
     const CGSize size = self.bounds.size;
     if (_mountedLayout.component != _component || !CGSizeEqualToSize(_mountedLayout.size, size)) {
+      CKComponentLayoutReuse layoutReuse(_layoutReuseState);
       _mountedLayout = CKComputeRootComponentLayout(_component, {size, size});
+      _layoutReuseState = layoutReuse.nextState();
     }
     CKComponentBoundsAnimationApply(_boundsAnimation, ^{
       _mountedComponents = [CKMountComponentLayout(_mountedLayout, _containerView, _mountedComponents, nil) copy];
@@ -138,6 +143,7 @@ struct CKComponentHostingViewInputs {
   CKAssertMainThread();
   [self _synchronouslyUpdateComponentIfNeeded];
   const CKSizeRange constrainedSize = [_sizeRangeProvider sizeRangeForBoundingSize:size];
+  CKComponentLayoutReuse layoutReuse(_layoutReuseState);
   return CKComputeRootComponentLayout(_component, constrainedSize).size;
 }
 
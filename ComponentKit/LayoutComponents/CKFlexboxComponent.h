@@ -205,6 +205,14 @@ struct CKFlexboxComponentStyle {
   CKFlexboxWrap wrap;
   /** Padding applied to the container */
   CKFlexboxSpacing padding;
+  /**
+   Measures children whose constraints are known before layout on several threads at once. Only children stretched
+   along a fixed cross axis, with an unconstrained stacking dimension and point margins and padding, qualify; the rest
+   are measured as usual. The resulting layout is identical to a serial one.
+
+   Use it for stacks with several expensive children (e.g. text), and make sure those children's layout is thread safe.
+   */
+  BOOL measureChildrenInParallel;
 };
 
 struct CKFlexboxComponentChild {
@@ -17,37 +17,54 @@
 #import "CKInternalHelpers.h"
 #import "CKComponentLayout.h"
 #import "CKComponentLayoutBaseline.h"
+#import "CKComponentMemoizer.h"
+#import "CKMutex.h"
+#import "ComponentLayoutContext.h"
 
 const struct CKStackComponentLayoutExtraKeys CKStackComponentLayoutExtraKeys = {
   .hadOverflow = @"hadOverflow"
 };
 
 /*
- This class contains information about cached layout for FlexboxComponent child
+ This struct contains information about cached layout for FlexboxComponent child
+ All of them live in one arena per Yoga tree, see CKFlexboxChildCachedLayouts
  */
-@interface CKFlexboxChildCachedLayout : NSObject
-
-@property (nonatomic) CKComponent *component;
-@property (nonatomic) CKComponentLayout componentLayout;
-@property (nonatomic) float width;
-@property (nonatomic) float height;
-@property (nonatomic) YGMeasureMode widthMode;
-@property (nonatomic) YGMeasureMode heightMode;
-@property (nonatomic) CGSize parentSize;
-@property (nonatomic) CKFlexboxAlignSelf align;
-@property (nonatomic) NSInteger zIndex;
+struct CKFlexboxChildCachedLayout {
+  CKComponent *component;
+  CKComponentLayout componentLayout;
+  float width;
+  float height;
+  YGMeasureMode widthMode;
+  YGMeasureMode heightMode;
+  CGSize parentSize;
+  CKFlexboxAlignSelf align;
+  NSInteger zIndex;
+  /** Set when the constraints Yoga is going to measure the child with are known before layout */
+  BOOL hasPredictedMeasurement;
+  float predictedWidth;
+  float predictedHeight;
+  YGMeasureMode predictedWidthMode;
+  YGMeasureMode predictedHeightMode;
+};
 
-@end
+/*
+ The arena is allocated once along with the tree and is never resized, so children's contexts can point
+ straight into it. It's owned by the context of the root node.
+ */
+typedef std::vector<CKFlexboxChildCachedLayout> CKFlexboxChildCachedLayouts;
 
 template class std::vector<CKFlexboxComponentChild>;
 
-@implementation CKFlexboxChildCachedLayout
-
-@end
-
 @implementation CKFlexboxComponent {
   CKFlexboxComponentStyle _style;
   std::vector<CKFlexboxComponentChild> _children;
+  // Yoga tree kept between layouts of this component during a layout pass, guarded by _layoutNodeMutex. It costs a
+  // Yoga node and a CKFlexboxChildCachedLayout per child, and the cached child layouts keep the layouts of the children
+  // alive, so it is freed at the end of the pass (see CK::Component::LayoutPass) rather than kept for as long as the
+  // component, which data source items and layout reuse states keep alive for the life of a feed. Layouts outside of
+  // a pass, e.g. on threads measuring children in parallel, don't keep it at all.
+  YGNodeRef _layoutNode;
+  CK::Mutex _layoutNodeMutex;
 }
 
 + (instancetype)newWithView:(const CKComponentViewConfiguration &)view
@@ -63,6 +80,13 @@ template class std::vector<CKFlexboxComponentChild>;
   return component;
 }
 
+- (void)dealloc
+{
+  if (_layoutNode) {
+    freeYgNode(_layoutNode);
+  }
+}
+
 static YGConfigRef ckYogaDefaultConfig()
 {
   static YGConfigRef defaultConfig;
@@ -74,13 +98,12 @@ static YGConfigRef ckYogaDefaultConfig()
   return defaultConfig;
 }
 
-static YGSize measureCssComponent(YGNodeRef node,
-                                  float width,
-                                  YGMeasureMode widthMode,
-                                  float height,
-                                  YGMeasureMode heightMode)
+static void measureChild(CKFlexboxChildCachedLayout *cachedLayout,
+                         float width,
+                         YGMeasureMode widthMode,
+                         float height,
+                         YGMeasureMode heightMode)
 {
-  CKFlexboxChildCachedLayout *cachedLayout = (__bridge CKFlexboxChildCachedLayout *)YGNodeGetContext(node);
   const CGSize minSize = {
     .width = (widthMode == YGMeasureModeExactly) ? width : 0,
     .height = (heightMode == YGMeasureModeExactly) ? height : 0
@@ -89,47 +112,57 @@ static YGSize measureCssComponent(YGNodeRef node,
     .width = (widthMode == YGMeasureModeExactly || widthMode == YGMeasureModeAtMost) ? width : INFINITY,
     .height = (heightMode == YGMeasureModeExactly || heightMode == YGMeasureModeAtMost) ? height : INFINITY
   };
-  // We cache measurements for the duration of single layout calculation of FlexboxComponent
-  // ComponentKit and Yoga handle caching between calculations
+  CKComponent *component = cachedLayout->component;
+  CKComponentLayout componentLayout = CKComputeComponentLayout(component, CKSizeRange(minSize, maxSize), cachedLayout->parentSize);
+  cachedLayout->componentLayout = componentLayout;
+  cachedLayout->width = width;
+  cachedLayout->height = height;
+  cachedLayout->widthMode = widthMode;
+  cachedLayout->heightMode = heightMode;
+}
+
+static YGSize measureCssComponent(YGNodeRef node,
+                                  float width,
+                                  YGMeasureMode widthMode,
+                                  float height,
+                                  YGMeasureMode heightMode)
+{
+  CKFlexboxChildCachedLayout *cachedLayout = static_cast<CKFlexboxChildCachedLayout *>(YGNodeGetContext(node));
+  // We cache measurements along with the Yoga tree, which is kept between layouts of FlexboxComponent
+  // Yoga skips the children whose constraints and styles haven't changed since
   // We don't have any guarantees about when and how this will be called,
   // so we just cache the results to try to reuse them during final layout
   if (!YGNodeCanUseCachedMeasurement(widthMode, width, heightMode, height,
-                                     cachedLayout.widthMode, cachedLayout.width, cachedLayout.heightMode, cachedLayout.height,
-                                     cachedLayout.componentLayout.size.width, cachedLayout.componentLayout.size.height, 0, 0,
+                                     cachedLayout->widthMode, cachedLayout->width, cachedLayout->heightMode, cachedLayout->height,
+                                     cachedLayout->componentLayout.size.width, cachedLayout->componentLayout.size.height, 0, 0,
                                      ckYogaDefaultConfig())) {
-    CKComponent *component = cachedLayout.component;
-    CKComponentLayout componentLayout = CKComputeComponentLayout(component, CKSizeRange(minSize, maxSize), cachedLayout.parentSize);
-    cachedLayout.componentLayout = componentLayout;
-    cachedLayout.width = width;
-    cachedLayout.height = height;
-    cachedLayout.widthMode = widthMode;
-    cachedLayout.heightMode = heightMode;
-  }
-  return {static_cast<float>(cachedLayout.componentLayout.size.width), static_cast<float>(cachedLayout.componentLayout.size.height)};
+    measureChild(cachedLayout, width, widthMode, height, heightMode);
+  }
+  return {static_cast<float>(cachedLayout->componentLayout.size.width), static_cast<float>(cachedLayout->componentLayout.size.height)};
 }
 
 static float computeBaseline(YGNodeRef node, const float width, const float height)
 {
-  CKFlexboxChildCachedLayout *cachedLayout = (__bridge CKFlexboxChildCachedLayout *)YGNodeGetContext(node);
+  CKFlexboxChildCachedLayout *cachedLayout = static_cast<CKFlexboxChildCachedLayout *>(YGNodeGetContext(node));
 
   if (!YGNodeCanUseCachedMeasurement(YGMeasureModeExactly, width, YGMeasureModeExactly, height,
-                                    cachedLayout.widthMode, cachedLayout.width,
-                                    cachedLayout.heightMode, cachedLayout.height,
-                                    cachedLayout.componentLayout.size.width, cachedLayout.componentLayout.size.height, 0, 0,
+                                    cachedLayout->widthMode, cachedLayout->width,
+                                    cachedLayout->heightMode, cachedLayout->height,
+                                    cachedLayout->componentLayout.size.width, cachedLayout->componentLayout.size.height, 0, 0,
                                     ckYogaDefaultConfig())) {
-    CKComponent *component = cachedLayout.component;
+    CKComponent *component = cachedLayout->component;
     CGSize fixedSize = {width, height};
-    CKComponentLayout componentLayout = CKComputeComponentLayout(component, CKSizeRange(fixedSize, fixedSize), cachedLayout.parentSize);
-    cachedLayout.componentLayout = componentLayout;
-    cachedLayout.width = width;
-    cachedLayout.height = height;
-    cachedLayout.widthMode = YGMeasureModeExactly;
-    cachedLayout.heightMode = YGMeasureModeExactly;
+    CKComponentLayout componentLayout = CKComputeComponentLayout(component, CKSizeRange(fixedSize, fixedSize), cachedLayout->parentSize);
+    cachedLayout->componentLayout = componentLayout;
+    cachedLayout->width = width;
+    cachedLayout->height = height;
+    cachedLayout->widthMode = YGMeasureModeExactly;
+    cachedLayout->heightMode = YGMeasureModeExactly;
   }
 
-  if ([cachedLayout.componentLayout.extra objectForKey:kCKComponentLayoutExtraBaselineKey]) {
-    CKCAssert([[cachedLayout.componentLayout.extra objectForKey:kCKComponentLayoutExtraBaselineKey] isKindOfClass:[NSNumber class]], @"You must set a NSNumber for kCKComponentLayoutExtraBaselineKey");
-    return [[cachedLayout.componentLayout.extra objectForKey:kCKComponentLayoutExtraBaselineKey] floatValue];
+  if ([cachedLayout->componentLayout.extra objectForKey:kCKComponentLayoutExtraBaselineKey]) {
+    CKCAssert([[cachedLayout->componentLayout.extra objectForKey:kCKComponentLayoutExtraBaselineKey] isKindOfClass:[NSNumber class]], @"You must set a NSNumber for kCKComponentLayoutExtraBaselineKey");
+    return [[cachedLayout->componentLayout.extra objectForKey:kCKComponentLayoutExtraBaselineKey] floatValue];
   }
 
   return height;
@@ -230,72 +263,173 @@ static YGWrap ygWrapFromStackStyle(const CKFlexboxComponentStyle &style)
 }
 
 /*
- layoutCache is passed by reference so that we are able to allocate it in one thread
- and mutate it within that thread
- Layout cache shouldn't be exposed publicly
+ Returns the value of a margin or padding given in points, 0 if it's unset and NAN if it can't be known
+ before layout (percentages, auto margins)
+ */
+static CGFloat pointsBeforeLayout(CKFlexboxDimension value, BOOL isMargin)
+{
+  if (isMargin && value.isDefined() == false) {
+    return 0;
+  }
+  const CKRelativeDimension dimension = value.dimension();
+  switch (dimension.type()) {
+    case CKRelativeDimension::Type::POINTS:
+      return dimension.value();
+    case CKRelativeDimension::Type::AUTO:
+      return isMargin ? NAN : 0;
+    case CKRelativeDimension::Type::PERCENT:
+      return NAN;
+  }
+}
+
+/*
+ Works out the constraints Yoga is going to measure the child with, for the case where they don't depend
+ on any other child: the child is stretched along a fixed cross axis and its stacking dimension is unconstrained.
+ Yoga then measures it exactly with the container's inner cross size, minus the child's own margins and padding.
+ A wrong guess is harmless as Yoga just measures the child again.
+ */
+static void predictMeasurement(CKFlexboxChildCachedLayout *childLayout,
+                               const CKFlexboxComponentChild &child,
+                               const CKFlexboxComponentStyle &style,
+                               const CKSizeRange &constrainedSize)
+{
+  // Reversed horizontal stacks emulate spacing with top and bottom margins, which lie on the cross axis
+  if (style.direction == CKFlexboxDirectionHorizontalReverse || style.wrap != CKFlexboxWrapNoWrap) {
+    return;
+  }
+  const BOOL isRow = (style.direction == CKFlexboxDirectionHorizontal);
+  const CGFloat crossSize = isRow ? constrainedSize.min.height : constrainedSize.min.width;
+  const CGFloat maxCrossSize = isRow ? constrainedSize.max.height : constrainedSize.max.width;
+  const CGFloat maxMainSize = isRow ? constrainedSize.max.width : constrainedSize.max.height;
+  if (crossSize != maxCrossSize || isinf(crossSize) || !isinf(maxMainSize)) {
+    return;
+  }
+
+  const BOOL isStretched = child.alignSelf == CKFlexboxAlignSelfStretch ||
+  (child.alignSelf == CKFlexboxAlignSelfAuto && style.alignItems == CKFlexboxAlignItemsStretch);
+  if (!isStretched || child.position.type == CKFlexboxPositionTypeAbsolute || child.aspectRatio.isDefined()) {
+    return;
+  }
+
+  const CKComponentSize size = [child.component size];
+  for (const CKRelativeDimension &dimension : {size.width, size.height, size.minWidth, size.minHeight, size.maxWidth, size.maxHeight, child.flexBasis}) {
+    if (dimension.type() != CKRelativeDimension::Type::AUTO) {
+      return;
+    }
+  }
+
+  const CGFloat innerCrossSize = crossSize
+  - (isRow ? pointsBeforeLayout(style.padding.top, NO) + pointsBeforeLayout(style.padding.bottom, NO)
+           : pointsBeforeLayout(style.padding.start, NO) + pointsBeforeLayout(style.padding.end, NO))
+  - (isRow ? pointsBeforeLayout(child.margin.top, YES) + pointsBeforeLayout(child.margin.bottom, YES)
+           : pointsBeforeLayout(child.margin.start, YES) + pointsBeforeLayout(child.margin.end, YES))
+  - (isRow ? pointsBeforeLayout(child.padding.top, NO) + pointsBeforeLayout(child.padding.bottom, NO)
+           : pointsBeforeLayout(child.padding.start, NO) + pointsBeforeLayout(child.padding.end, NO));
+  if (isnan(innerCrossSize)) {
+    return;
+  }
+
+  const float measuredCrossSize = static_cast<float>(MAX(innerCrossSize, 0));
+  childLayout->hasPredictedMeasurement = YES;
+  childLayout->predictedWidth = isRow ? YGUndefined : measuredCrossSize;
+  childLayout->predictedWidthMode = isRow ? YGMeasureModeUndefined : YGMeasureModeExactly;
+  childLayout->predictedHeight = isRow ? measuredCrossSize : YGUndefined;
+  childLayout->predictedHeightMode = isRow ? YGMeasureModeExactly : YGMeasureModeUndefined;
+}
+
+/*
+ Measures the children whose constraints could be predicted on the global concurrent queue, so that
+ Yoga finds their measurements in the cache. Workers don't share this thread's layout stack or memoizer,
+ so both are handed over explicitly.
  */
-- (YGNodeRef)cssStackLayoutNode:(CKSizeRange)constrainedSize
+static void measurePredictedChildrenInParallel(YGNodeRef node)
+{
+  std::vector<CKFlexboxChildCachedLayout *> childLayouts;
+  const uint32_t childCount = YGNodeGetChildCount(node);
+  for (uint32_t i = 0; i < childCount; i++) {
+    CKFlexboxChildCachedLayout *childLayout = static_cast<CKFlexboxChildCachedLayout *>(YGNodeGetContext(YGNodeGetChild(node, i)));
+    // Children measured with the same constraints in a previous layout are already in the cache
+    if (childLayout->hasPredictedMeasurement &&
+        !YGNodeCanUseCachedMeasurement(childLayout->predictedWidthMode, childLayout->predictedWidth,
+                                       childLayout->predictedHeightMode, childLayout->predictedHeight,
+                                       childLayout->widthMode, childLayout->width,
+                                       childLayout->heightMode, childLayout->height,
+                                       childLayout->componentLayout.size.width, childLayout->componentLayout.size.height, 0, 0,
+                                       ckYogaDefaultConfig())) {
+      childLayouts.push_back(childLayout);
+    }
+  }
+  if (childLayouts.size() < 2) {
+    return;
+  }
+
+  const CK::Component::LayoutContextStack stack = CK::Component::LayoutContext::currentStack();
+  const CK::Component::LayoutContextStack *inheritedStack = &stack;
+  CKFlexboxChildCachedLayout *const *layouts = childLayouts.data();
+  id memoizerState = CKComponentMemoizer::currentMemoizerState();
+  dispatch_apply(childLayouts.size(), dispatch_get_global_queue(qos_class_self(), 0), ^(size_t i) {
+    CK::Component::InheritedLayoutContextStack inherited(*inheritedStack);
+    CKFlexboxChildCachedLayout *childLayout = layouts[i];
+    void (^measure)(void) = ^{
+      measureChild(childLayout,
+                   childLayout->predictedWidth, childLayout->predictedWidthMode,
+                   childLayout->predictedHeight, childLayout->predictedHeightMode);
+    };
+    if (memoizerState) {
+      CKComponentMemoizer memoizer(memoizerState);
+      measure();
+    } else {
+      measure();
+    }
+  });
+}
+
+/*
+ Builds the Yoga tree for the children along with every style that doesn't depend on the size range,
+ which -updateYgNode:constrainedSize: fills in before each layout. The tree is kept around between layouts
+ of the same pass so Yoga's own cache can skip children whose constraints and styles haven't changed.
+ */
+- (YGNodeRef)cssStackLayoutNode
 {
   const YGNodeRef stackNode = YGNodeNewWithConfig(ckYogaDefaultConfig());
   YGEdge spacingEdge = _style.direction == CKFlexboxDirectionHorizontal ? YGEdgeStart : YGEdgeTop;
   CGFloat savedSpacing = 0;
-  // We need this to resolve CKRelativeDimension with percentage bases
-  CGFloat parentWidth = (constrainedSize.min.width == constrainedSize.max.width) ? constrainedSize.min.width : kCKComponentParentDimensionUndefined;
-  CGFloat parentHeight = (constrainedSize.min.height == constrainedSize.max.height) ? constrainedSize.min.height : kCKComponentParentDimensionUndefined;
-  CGFloat parentMainDimension = (_style.direction == CKFlexboxDirectionHorizontal) ? parentWidth : parentHeight;
-  CGSize parentSize = CGSizeMake(parentWidth, parentHeight);
 
   const auto children = CK::filter(_children, [](const CKFlexboxComponentChild &child){
     return child.component != nil;
   });
 
+  // The root node's context owns the arena, which we free along with the tree
+  CKFlexboxChildCachedLayouts *childLayouts = new CKFlexboxChildCachedLayouts(children.size());
+  YGNodeSetContext(stackNode, childLayouts);
+
   for (auto iterator = children.begin(); iterator != children.end(); iterator++) {
     const CKFlexboxComponentChild child = *iterator;
-    CKComponent *childComponent = child.component;
     const YGNodeRef childNode = YGNodeNewWithConfig(ckYogaDefaultConfig());
 
-    // We add object only if there is actual used element
-    CKFlexboxChildCachedLayout *childLayout = [CKFlexboxChildCachedLayout new];
-    childLayout.component = child.component;
-    childLayout.componentLayout = {child.component, {0, 0}};
-    childLayout.widthMode = (YGMeasureMode) -1;
-    childLayout.heightMode = (YGMeasureMode) -1;
-    childLayout.parentSize = parentSize;
-    childLayout.align = child.alignSelf;
-    childLayout.zIndex = child.zIndex;
+    // We add an entry only if there is actual used element
+    CKFlexboxChildCachedLayout *childLayout = &(*childLayouts)[iterator - children.begin()];
+    childLayout->component = child.component;
+    childLayout->componentLayout = {child.component, {0, 0}};
+    childLayout->widthMode = (YGMeasureMode) -1;
+    childLayout->heightMode = (YGMeasureMode) -1;
+    childLayout->parentSize = kCKComponentParentSizeUndefined;
+    childLayout->align = child.alignSelf;
+    childLayout->zIndex = child.zIndex;
     if (child.aspectRatio.isDefined()) {
       YGNodeStyleSetAspectRatio(childNode, child.aspectRatio.aspectRatio());
     }
 
-    // We pass the pointer ownership to context to release it later.
-    // We want cachedLayout to be alive until we've finished calculations
-    YGNodeSetContext(childNode, (__bridge_retained void *)childLayout);
+    YGNodeSetContext(childNode, childLayout);
     YGNodeSetMeasureFunc(childNode, measureCssComponent);
     YGNodeSetBaselineFunc(childNode, computeBaseline);
 
-    const CKComponentSize childComponentSize = [childComponent size];
-
-    YGNodeStyleSetWidth(childNode, childComponentSize.width.resolve(YGUndefined, parentWidth));
-    YGNodeStyleSetHeight(childNode, childComponentSize.height.resolve(YGUndefined, parentHeight));
-    YGNodeStyleSetMinWidth(childNode, childComponentSize.minWidth.resolve(YGUndefined, parentWidth));
-    YGNodeStyleSetMinHeight(childNode, childComponentSize.minHeight.resolve(YGUndefined, parentHeight));
-    YGNodeStyleSetMaxWidth(childNode, childComponentSize.maxWidth.resolve(YGUndefined, parentWidth));
-    YGNodeStyleSetMaxHeight(childNode, childComponentSize.maxHeight.resolve(YGUndefined, parentHeight));
-
     YGNodeStyleSetFlexGrow(childNode, child.flexGrow);
     YGNodeStyleSetFlexShrink(childNode, child.flexShrink);
     YGNodeStyleSetAlignSelf(childNode, ygAlignFromChild(child));
-    YGNodeStyleSetFlexBasis(childNode, child.flexBasis.resolve(YGUndefined, parentMainDimension));
     // TODO: t18095186 Remove explicit opt-out when Yoga is going to move to opt-in for text rounding
     YGNodeSetNodeType(childNode, child.useTextRounding ? YGNodeTypeText : YGNodeTypeDefault);
 
-    YGNodeStyleSetPosition(childNode, YGEdgeStart, child.position.start.resolve(YGUndefined, parentMainDimension));
-    YGNodeStyleSetPosition(childNode, YGEdgeEnd, child.position.end.resolve(YGUndefined, parentMainDimension));
-    YGNodeStyleSetPosition(childNode, YGEdgeTop, child.position.top.resolve(YGUndefined, parentHeight));
-    YGNodeStyleSetPosition(childNode, YGEdgeBottom, child.position.bottom.resolve(YGUndefined, parentHeight));
-    YGNodeStyleSetPosition(childNode, YGEdgeLeft, child.position.left.resolve(YGUndefined, parentWidth));
-    YGNodeStyleSetPosition(childNode, YGEdgeRight, child.position.right.resolve(YGUndefined, parentWidth));
-
     applyPaddingToEdge(childNode, YGEdgeTop, child.padding.top);
     applyPaddingToEdge(childNode, YGEdgeBottom, child.padding.bottom);
     applyPaddingToEdge(childNode, YGEdgeStart, child.padding.start);
@@ -356,6 +490,101 @@ static YGWrap ygWrapFromStackStyle(const CKFlexboxComponentStyle &style)
   return stackNode;
 }
 
+static BOOL parentDimensionsEqual(CGFloat a, CGFloat b)
+{
+  return a == b || (isnan(a) && isnan(b));
+}
+
+/*
+ Applies the styles that depend on the size range. Yoga only marks a node dirty when a style actually
+ changes, so laying out again at the same size leaves the whole tree clean.
+ */
+- (void)updateYgNode:(YGNodeRef)stackNode constrainedSize:(CKSizeRange)constrainedSize
+{
+  // We need this to resolve CKRelativeDimension with percentage bases
+  CGFloat parentWidth = (constrainedSize.min.width == constrainedSize.max.width) ? constrainedSize.min.width : kCKComponentParentDimensionUndefined;
+  CGFloat parentHeight = (constrainedSize.min.height == constrainedSize.max.height) ? constrainedSize.min.height : kCKComponentParentDimensionUndefined;
+  CGFloat parentMainDimension = (_style.direction == CKFlexboxDirectionHorizontal) ? parentWidth : parentHeight;
+  CGSize parentSize = CGSizeMake(parentWidth, parentHeight);
+
+  uint32_t childIndex = 0;
+  for (const CKFlexboxComponentChild &child : _children) {
+    if (child.component == nil) {
+      continue;
+    }
+    const YGNodeRef childNode = YGNodeGetChild(stackNode, childIndex++);
+    CKFlexboxChildCachedLayout *childLayout = static_cast<CKFlexboxChildCachedLayout *>(YGNodeGetContext(childNode));
+
+    if (!parentDimensionsEqual(childLayout->parentSize.width, parentWidth) ||
+        !parentDimensionsEqual(childLayout->parentSize.height, parentHeight)) {
+      // Measurements made against another parent size can't be reused, neither by us nor by Yoga
+      childLayout->parentSize = parentSize;
+      childLayout->widthMode = (YGMeasureMode) -1;
+      childLayout->heightMode = (YGMeasureMode) -1;
+      YGNodeMarkDirty(childNode);
+    }
+    childLayout->hasPredictedMeasurement = NO;
+    if (_style.measureChildrenInParallel) {
+      predictMeasurement(childLayout, child, _style, constrainedSize);
+    }
+
+    const CKComponentSize childComponentSize = [child.component size];
+
+    YGNodeStyleSetWidth(childNode, childComponentSize.width.resolve(YGUndefined, parentWidth));
+    YGNodeStyleSetHeight(childNode, childComponentSize.height.resolve(YGUndefined, parentHeight));
+    YGNodeStyleSetMinWidth(childNode, childComponentSize.minWidth.resolve(YGUndefined, parentWidth));
+    YGNodeStyleSetMinHeight(childNode, childComponentSize.minHeight.resolve(YGUndefined, parentHeight));
+    YGNodeStyleSetMaxWidth(childNode, childComponentSize.maxWidth.resolve(YGUndefined, parentWidth));
+    YGNodeStyleSetMaxHeight(childNode, childComponentSize.maxHeight.resolve(YGUndefined, parentHeight));
+
+    YGNodeStyleSetFlexBasis(childNode, child.flexBasis.resolve(YGUndefined, parentMainDimension));
+
+    YGNodeStyleSetPosition(childNode, YGEdgeStart, child.position.start.resolve(YGUndefined, parentMainDimension));
+    YGNodeStyleSetPosition(childNode, YGEdgeEnd, child.position.end.resolve(YGUndefined, parentMainDimension));
+    YGNodeStyleSetPosition(childNode, YGEdgeTop, child.position.top.resolve(YGUndefined, parentHeight));
+    YGNodeStyleSetPosition(childNode, YGEdgeBottom, child.position.bottom.resolve(YGUndefined, parentHeight));
+    YGNodeStyleSetPosition(childNode, YGEdgeLeft, child.position.left.resolve(YGUndefined, parentWidth));
+    YGNodeStyleSetPosition(childNode, YGEdgeRight, child.position.right.resolve(YGUndefined, parentWidth));
+  }
+
+  // At the moment Yoga does not optimise minWidth == maxWidth, so we want to do it here
+  // ComponentKit and Yoga use different constants for +Inf, so we need to make sure the don't interfere
+  // Whichever of the two we don't use is reset, as the node may have been laid out with the other before
+  if (constrainedSize.min.width == constrainedSize.max.width) {
+    YGNodeStyleSetWidth(stackNode, constrainedSize.min.width);
+    YGNodeStyleSetMinWidth(stackNode, YGUndefined);
+    YGNodeStyleSetMaxWidth(stackNode, YGUndefined);
+  } else {
+    YGNodeStyleSetWidth(stackNode, YGUndefined);
+    YGNodeStyleSetMinWidth(stackNode, constrainedSize.min.width);
+    if (constrainedSize.max.width == INFINITY) {
+      YGNodeStyleSetMaxWidth(stackNode, YGUndefined);
+    } else {
+      YGNodeStyleSetMaxWidth(stackNode, constrainedSize.max.width);
+    }
+  }
+
+  if (constrainedSize.min.height == constrainedSize.max.height) {
+    YGNodeStyleSetHeight(stackNode, constrainedSize.min.height);
+    YGNodeStyleSetMinHeight(stackNode, YGUndefined);
+    YGNodeStyleSetMaxHeight(stackNode, YGUndefined);
+  } else {
+    YGNodeStyleSetHeight(stackNode, YGUndefined);
+    YGNodeStyleSetMinHeight(stackNode, constrainedSize.min.height);
+    if (constrainedSize.max.height == INFINITY) {
+      YGNodeStyleSetMaxHeight(stackNode, YGUndefined);
+    } else {
+      YGNodeStyleSetMaxHeight(stackNode, constrainedSize.max.height);
+    }
+  }
+}
+
+static void freeYgNode(YGNodeRef node)
+{
+  delete static_cast<CKFlexboxChildCachedLayouts *>(YGNodeGetContext(node));
+  YGNodeFreeRecursive(node);
+}
+
 static void applyPaddingToEdge(YGNodeRef node, YGEdge edge, CKFlexboxDimension value)
 {
   CKRelativeDimension dimension = value.dimension();
@@ -420,11 +649,31 @@ static BOOL marginIsSet(CKFlexboxDimension margin)
 
 - (CKComponentLayout)computeLayoutThatFits:(CKSizeRange)constrainedSize
 {
-  // We create cache for the duration of single calculation, so it is used only on one thread
+  // The cache lives in the Yoga tree, which we keep for the next layout of this component in the same pass
   // The cache is strictly internal and shouldn't be exposed in any way
   // The purpose of the cache is to save calculations done in measure() function in Yoga to reuse
   // for final layout
-  YGNodeRef layoutNode = [self ygNode:constrainedSize];
+  // If another thread is laying out this component at the same time we just build a tree of our own
+  const BOOL reusesLayoutNode = CK::Component::LayoutPass::isInProgress()
+  && (pthread_mutex_trylock(_layoutNodeMutex.mutex()) == 0);
+  YGNodeRef layoutNode;
+  if (reusesLayoutNode) {
+    if (_layoutNode == NULL) {
+      _layoutNode = [self cssStackLayoutNode];
+      CK::Component::LayoutPass::addCompletion(^{
+        [self freeLayoutNode];
+      });
+    }
+    layoutNode = _layoutNode;
+    [self updateYgNode:layoutNode constrainedSize:constrainedSize];
+  } else {
+    layoutNode = [self ygNode:constrainedSize];
+  }
+
+  // Independent children are measured up front and joined here, before Yoga asks for their sizes
+  if (_style.measureChildrenInParallel) {
+    measurePredictedChildrenInParallel(layoutNode);
+  }
 
   YGNodeCalculateLayout(layoutNode, YGUndefined, YGUndefined, YGDirectionLTR);
 
@@ -438,9 +687,9 @@ static BOOL marginIsSet(CKFlexboxDimension margin)
   }
   std::sort(sortedChildNodes.begin(), sortedChildNodes.end(),
             [] (YGNodeRef const& a, YGNodeRef const& b) {
-              CKFlexboxChildCachedLayout *aCachedContext = (__bridge CKFlexboxChildCachedLayout *)YGNodeGetContext(a);
-              CKFlexboxChildCachedLayout *bCachedContext = (__bridge CKFlexboxChildCachedLayout *)YGNodeGetContext(b);
-              return aCachedContext.zIndex < bCachedContext.zIndex;
+              const auto aCachedContext = static_cast<CKFlexboxChildCachedLayout *>(YGNodeGetContext(a));
+              const auto bCachedContext = static_cast<CKFlexboxChildCachedLayout *>(YGNodeGetContext(b));
+              return aCachedContext->zIndex < bCachedContext->zIndex;
             });
 
   std::vector<CKComponentLayoutChild> childrenLayout(childCount);
@@ -454,20 +703,18 @@ static BOOL marginIsSet(CKFlexboxDimension margin)
     const CGFloat childY = YGNodeLayoutGetTop(childNode);
     const CGFloat childWidth = YGNodeLayoutGetWidth(childNode);
     const CGFloat childHeight = YGNodeLayoutGetHeight(childNode);
-    // Now we take back pointer ownership to be released, as we won't need it anymore
-    CKFlexboxChildCachedLayout *childCachedLayout = (__bridge_transfer CKFlexboxChildCachedLayout *)YGNodeGetContext(childNode);
+    CKFlexboxChildCachedLayout *childCachedLayout = static_cast<CKFlexboxChildCachedLayout *>(YGNodeGetContext(childNode));
 
     childrenLayout[i].position = CGPointMake(childX, childY);
     const CGSize childSize = CGSizeMake(childWidth, childHeight);
-    // We cache measurements for the duration of single layout calculation of FlexboxComponent
-    // ComponentKit and Yoga handle caching between calculations
+    // We cache measurements along with the Yoga tree, which is kept between layouts of FlexboxComponent
 
     // We can reuse caching even if main dimension isn't exact, but we did AtMost measurement previously
     // However we might need to measure anew if child needs to be stretched
     YGMeasureMode verticalReusedMode = YGMeasureModeAtMost;
     YGMeasureMode horizontalReusedMode = YGMeasureModeAtMost;
-    if (childCachedLayout.align == CKFlexboxAlignSelfStretch ||
-        (childCachedLayout.align == CKFlexboxAlignSelfAuto && _style.alignItems == CKFlexboxAlignItemsStretch)) {
+    if (childCachedLayout->align == CKFlexboxAlignSelfStretch ||
+        (childCachedLayout->align == CKFlexboxAlignSelfAuto && _style.alignItems == CKFlexboxAlignItemsStretch)) {
       if (_style.direction == CKFlexboxDirectionVertical) {
         horizontalReusedMode = YGMeasureModeExactly;
       } else {
@@ -476,63 +723,48 @@ static BOOL marginIsSet(CKFlexboxDimension margin)
     }
 
     if (YGNodeCanUseCachedMeasurement(horizontalReusedMode, childWidth, verticalReusedMode, childHeight,
-                                      childCachedLayout.widthMode, childCachedLayout.width,
-                                      childCachedLayout.heightMode, childCachedLayout.height,
-                                      childCachedLayout.componentLayout.size.width,
-                                      childCachedLayout.componentLayout.size.height, 0, 0,
+                                      childCachedLayout->widthMode, childCachedLayout->width,
+                                      childCachedLayout->heightMode, childCachedLayout->height,
+                                      childCachedLayout->componentLayout.size.width,
+                                      childCachedLayout->componentLayout.size.height, 0, 0,
                                       ckYogaDefaultConfig()) ||
         YGNodeCanUseCachedMeasurement(YGMeasureModeExactly, childWidth, YGMeasureModeExactly, childHeight,
-                                      childCachedLayout.widthMode, childCachedLayout.width,
-                                      childCachedLayout.heightMode, childCachedLayout.height,
-                                      childCachedLayout.componentLayout.size.width, childCachedLayout.componentLayout.size.height, 0, 0,
+                                      childCachedLayout->widthMode, childCachedLayout->width,
+                                      childCachedLayout->heightMode, childCachedLayout->height,
+                                      childCachedLayout->componentLayout.size.width, childCachedLayout->componentLayout.size.height, 0, 0,
                                       ckYogaDefaultConfig()) ||
         childSize.width == 0 ||
         childSize.height == 0) {
-      childrenLayout[i].layout = childCachedLayout.componentLayout;
+      childrenLayout[i].layout = childCachedLayout->componentLayout;
     } else {
-      childrenLayout[i].layout = CKComputeComponentLayout(childCachedLayout.component, {childSize, childSize}, size);
+      childrenLayout[i].layout = CKComputeComponentLayout(childCachedLayout->component, {childSize, childSize}, size);
     }
     childrenLayout[i].layout.size = childSize;
   }
 
-  YGNodeFreeRecursive(layoutNode);
+  if (reusesLayoutNode) {
+    _layoutNodeMutex.unlock();
+  } else {
+    freeYgNode(layoutNode);
+  }
 
   // width/height should already be within constrainedSize, but we're just clamping to correct for roundoff error
   return {self, constrainedSize.clamp({width, height}), childrenLayout};
 }
 
-/*
- layoutCache is passed by reference so that we are able to allocate it in one thread
- and mutate it within that thread
- Layout cache shouldn't be exposed publicly
- */
-- (YGNodeRef)ygNode:(CKSizeRange)constrainedSize
+- (void)freeLayoutNode
 {
-  const YGNodeRef node = [self cssStackLayoutNode:constrainedSize];
-
-  // At the moment Yoga does not optimise minWidth == maxWidth, so we want to do it here
-  // ComponentKit and Yoga use different constants for +Inf, so we need to make sure the don't interfere
-  if (constrainedSize.min.width == constrainedSize.max.width) {
-    YGNodeStyleSetWidth(node, constrainedSize.min.width);
-  } else {
-    YGNodeStyleSetMinWidth(node, constrainedSize.min.width);
-    if (constrainedSize.max.width == INFINITY) {
-      YGNodeStyleSetMaxWidth(node, YGUndefined);
-    } else {
-      YGNodeStyleSetMaxWidth(node, constrainedSize.max.width);
-    }
+  CK::MutexLocker l(_layoutNodeMutex);
+  if (_layoutNode) {
+    freeYgNode(_layoutNode);
+    _layoutNode = NULL;
   }
+}
 
-  if (constrainedSize.min.height == constrainedSize.max.height) {
-    YGNodeStyleSetHeight(node, constrainedSize.min.height);
-  } else {
-    YGNodeStyleSetMinHeight(node, constrainedSize.min.height);
-    if (constrainedSize.max.height == INFINITY) {
-      YGNodeStyleSetMaxHeight(node, YGUndefined);
-    } else {
-      YGNodeStyleSetMaxHeight(node, constrainedSize.max.height);
-    }
-  }
+- (YGNodeRef)ygNode:(CKSizeRange)constrainedSize
+{
+  const YGNodeRef node = [self cssStackLayoutNode];
+  [self updateYgNode:node constrainedSize:constrainedSize];
   return node;
 }
 
@@ -36,6 +36,19 @@
                   mode:(CKUpdateMode)mode
               userInfo:(NSDictionary *)userInfo;
 
+/**
+ Asynchronously applies a changeset that only inserts sections and items in chunks of at most chunkSize items, taken in
+ index path order. Each chunk is announced to listeners as a separate change with the same userInfo as soon as it is
+ ready, so the first items (e.g. enough to fill the viewport) show up without waiting for the whole changeset.
+
+ Changesets that do anything other than inserting are applied asynchronously as a whole, as are those with a chunkSize
+ of 0. Changesets applied afterwards still wait for every chunk, and applying one synchronously applies the remaining
+ chunks first.
+ */
+- (void)applyChangesetProgressively:(CKDataSourceChangeset *)changeset
+                          chunkSize:(NSUInteger)chunkSize
+                           userInfo:(NSDictionary *)userInfo;
+
 /** Updates the configuration object, updating all existing components. */
 - (void)updateConfiguration:(CKTransactionalComponentDataSourceConfiguration *)configuration
                        mode:(CKUpdateMode)mode
@@ -17,6 +17,7 @@
 #import "CKComponentDebugController.h"
 #import "CKComponentScopeRoot.h"
 #import "CKComponentSubclass.h"
+#import "CKDataSourceChangesetInternal.h"
 #import "CKTransactionalComponentDataSourceAppliedChanges.h"
 #import "CKTransactionalComponentDataSourceChange.h"
 #import "CKTransactionalComponentDataSourceChangesetModification.h"
@@ -107,6 +108,19 @@
   }
 }
 
+- (void)applyChangesetProgressively:(CKDataSourceChangeset *)changeset
+                          chunkSize:(NSUInteger)chunkSize
+                           userInfo:(NSDictionary *)userInfo
+{
+  CKAssertMainThread();
+  verifyChangeset(changeset, _state, _pendingAsynchronousModifications);
+  // The chunks are enqueued back to back, so they are applied in order and before anything enqueued later
+  for (CKDataSourceChangeset *chunk in chunksOfChangeset(changeset, chunkSize)) {
+    [self _enqueueModification:
+     [[CKTransactionalComponentDataSourceChangesetModification alloc] initWithChangeset:chunk stateListener:self userInfo:userInfo]];
+  }
+}
+
 - (void)updateConfiguration:(CKTransactionalComponentDataSourceConfiguration *)configuration
                        mode:(CKUpdateMode)mode
                    userInfo:(NSDictionary *)userInfo
@@ -304,6 +318,40 @@ static void getComponentsFromLayout(CKComponentLayout layout, std::vector<CKComp
   }
 }
 
+/**
+ Splits a changeset that only inserts into changesets of at most chunkSize inserted items, in index path order; other
+ changesets are returned as is. Inserted index paths are final positions, so applying the items with the lowest ones
+ first leaves every chunk's index paths valid. The sections are inserted with the first chunk.
+ */
+static NSArray<CKDataSourceChangeset *> *chunksOfChangeset(CKDataSourceChangeset *changeset, NSUInteger chunkSize)
+{
+  NSDictionary *insertedItems = [changeset insertedItems];
+  if (chunkSize == 0
+      || [insertedItems count] <= chunkSize
+      || [[changeset updatedItems] count] > 0
+      || [[changeset removedItems] count] > 0
+      || [[changeset removedSections] count] > 0
+      || [[changeset movedItems] count] > 0) {
+    return @[changeset];
+  }
+
+  NSArray<NSIndexPath *> *indexPaths = [[insertedItems allKeys] sortedArrayUsingSelector:@selector(compare:)];
+  NSMutableArray<CKDataSourceChangeset *> *chunks = [NSMutableArray array];
+  for (NSUInteger start = 0; start < [indexPaths count]; start += chunkSize) {
+    NSMutableDictionary *chunkItems = [NSMutableDictionary dictionary];
+    for (NSIndexPath *indexPath in [indexPaths subarrayWithRange:NSMakeRange(start, MIN(chunkSize, [indexPaths count] - start))]) {
+      chunkItems[indexPath] = insertedItems[indexPath];
+    }
+    [chunks addObject:[[CKDataSourceChangeset alloc] initWithUpdatedItems:nil
+                                                             removedItems:nil
+                                                          removedSections:nil
+                                                               movedItems:nil
+                                                         insertedSections:(start == 0 ? [changeset insertedSections] : nil)
+                                                            insertedItems:chunkItems]];
+  }
+  return chunks;
+}
+
 static void verifyChangeset(CKDataSourceChangeset *changeset,
                             CKTransactionalComponentDataSourceState *state,
                             NSArray<id<CKTransactionalComponentDataSourceStateModifying>> *pendingAsynchronousModifications)
@@ -38,9 +38,29 @@
                                 sizeRange:(const CKSizeRange &)sizeRange
                 alwaysSendComponentUpdate:(BOOL)alwaysSendComponentUpdate;
 
+/**
+ @param componentProvider See @protocol(CKComponentProvider)
+ @param context Passed to methods exposed by @protocol(CKComponentProvider).
+ @param sizeRange Used for the root layout.
+ @param alwaysSendComponentUpdate If set to YES, CKTransactionalComponentDataSource with this config
+        will send component update events to component controllers even when they aren't in viewport
+ @param buildParallelism The maximum number of items of a changeset that are built and laid out at the same time.
+        Items are independent of each other, so a value above 1 lets large changesets use several cores; the component
+        provider must then be safe to call from several threads at once. Passing 0 is the same as passing 1, which
+        builds the items one after another and is the default. Ignored when the data source works on a thread of its
+        own (workThreadOverride), since items are then only built on that thread. Not part of equality, since it
+        doesn't change what is built.
+ */
+- (instancetype)initWithComponentProvider:(Class<CKComponentProvider>)componentProvider
+                                  context:(id<NSObject>)context
+                                sizeRange:(const CKSizeRange &)sizeRange
+                alwaysSendComponentUpdate:(BOOL)alwaysSendComponentUpdate
+                         buildParallelism:(NSUInteger)buildParallelism;
+
 @property (nonatomic, strong, readonly) Class<CKComponentProvider> componentProvider;
 @property (nonatomic, strong, readonly) id<NSObject> context;
 @property (nonatomic, assign, readonly) BOOL alwaysSendComponentUpdate;
+@property (nonatomic, assign, readonly) NSUInteger buildParallelism;
 
 - (const CKSizeRange &)sizeRange;
 
@@ -39,7 +39,21 @@
   return [self initWithComponentProvider:componentProvider
                                  context:context
                                sizeRange:sizeRange
-          alwaysSendComponentUpdate:alwaysSendComponentUpdate
+               alwaysSendComponentUpdate:alwaysSendComponentUpdate
+                        buildParallelism:1];
+}
+
+- (instancetype)initWithComponentProvider:(Class<CKComponentProvider>)componentProvider
+                                  context:(id<NSObject>)context
+                                sizeRange:(const CKSizeRange &)sizeRange
+                alwaysSendComponentUpdate:(BOOL)alwaysSendComponentUpdate
+                         buildParallelism:(NSUInteger)buildParallelism
+{
+  return [self initWithComponentProvider:componentProvider
+                                 context:context
+                               sizeRange:sizeRange
+               alwaysSendComponentUpdate:alwaysSendComponentUpdate
+                        buildParallelism:buildParallelism
                       workThreadOverride:nil
                      componentPredicates:{}
            componentControllerPredicates:{}];
@@ -69,6 +83,7 @@
                                  context:context
                                sizeRange:sizeRange
                alwaysSendComponentUpdate:NO
+                        buildParallelism:1
                       workThreadOverride:workThreadOverride
                      componentPredicates:componentPredicates
            componentControllerPredicates:componentControllerPredicates];
@@ -78,6 +93,7 @@
                                   context:(id<NSObject>)context
                                 sizeRange:(const CKSizeRange &)sizeRange
                 alwaysSendComponentUpdate:(BOOL)alwaysSendComponentUpdate
+                         buildParallelism:(NSUInteger)buildParallelism
                        workThreadOverride:(NSThread *)workThreadOverride
                       componentPredicates:(const std::unordered_set<CKComponentScopePredicate> &)componentPredicates
             componentControllerPredicates:(const std::unordered_set<CKComponentControllerScopePredicate> &)componentControllerPredicates
@@ -90,6 +106,7 @@
     _componentPredicates = componentPredicates;
     _componentControllerPredicates = componentControllerPredicates;
     _alwaysSendComponentUpdate = alwaysSendComponentUpdate;
+    _buildParallelism = MAX(buildParallelism, (NSUInteger)1);
   }
   return self;
 }
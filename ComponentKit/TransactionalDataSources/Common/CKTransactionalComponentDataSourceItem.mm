@@ -24,12 +24,22 @@
                          model:(id)model
                      scopeRoot:(CKComponentScopeRoot *)scopeRoot
                boundsAnimation:(CKComponentBoundsAnimation)boundsAnimation
+{
+  return [self initWithLayout:layout model:model scopeRoot:scopeRoot boundsAnimation:boundsAnimation layoutReuseState:nil];
+}
+
+- (instancetype)initWithLayout:(const CKComponentLayout &)layout
+                         model:(id)model
+                     scopeRoot:(CKComponentScopeRoot *)scopeRoot
+               boundsAnimation:(CKComponentBoundsAnimation)boundsAnimation
+              layoutReuseState:(id)layoutReuseState
 {
   if (self = [super init]) {
     _layout = layout;
     _model = model;
     _scopeRoot = scopeRoot;
     _boundsAnimation = boundsAnimation;
+    _layoutReuseState = layoutReuseState;
   }
   return self;
 }
@@ -18,4 +18,13 @@
                      scopeRoot:(CKComponentScopeRoot *)scopeRoot
                boundsAnimation:(CKComponentBoundsAnimation)boundsAnimation;
 
+- (instancetype)initWithLayout:(const CKComponentLayout &)layout
+                         model:(id)model
+                     scopeRoot:(CKComponentScopeRoot *)scopeRoot
+               boundsAnimation:(CKComponentBoundsAnimation)boundsAnimation
+              layoutReuseState:(id)layoutReuseState;
+
+/** The state of the CKComponentLayoutReuse the layout was computed in, if any; lets the next layout reuse parts of it. */
+@property (nonatomic, strong, readonly) id layoutReuseState;
+
 @end
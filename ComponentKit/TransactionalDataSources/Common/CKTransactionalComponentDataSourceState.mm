@@ -10,19 +10,34 @@
 
 #import "CKTransactionalComponentDataSourceStateInternal.h"
 
+#import "CKComponentScopeRoot.h"
 #import "CKEqualityHashHelpers.h"
 #import "CKMacros.h"
+#import "CKMutex.h"
 #import "CKTransactionalComponentDataSourceConfiguration.h"
 #import "CKTransactionalComponentDataSourceItem.h"
 
 @implementation CKTransactionalComponentDataSourceState
+{
+  std::shared_ptr<const CKTransactionalComponentDataSourceScopeRootIndex> _scopeRootIndex;
+  CK::Mutex _scopeRootIndexMutex;
+}
 
 - (instancetype)initWithConfiguration:(CKTransactionalComponentDataSourceConfiguration *)configuration
                              sections:(NSArray *)sections
+{
+  return [self initWithConfiguration:configuration sections:sections scopeRootIndex:nullptr];
+}
+
+- (instancetype)initWithConfiguration:(CKTransactionalComponentDataSourceConfiguration *)configuration
+                             sections:(NSArray *)sections
+                       scopeRootIndex:(std::shared_ptr<const CKTransactionalComponentDataSourceScopeRootIndex>)scopeRootIndex
 {
   if (self = [super init]) {
     _configuration = configuration;
-    _sections = [[NSArray alloc] initWithArray:sections copyItems:YES]; // Deep copy for safety
+    _scopeRootIndex = scopeRootIndex;
+    // Copying the sections only copies the mutable ones; immutable sections are shared with the state they came from
+    _sections = [[NSArray alloc] initWithArray:sections copyItems:YES];
   }
   return self;
 }
@@ -43,6 +58,42 @@
   return [[_sections objectAtIndex:[indexPath section]] objectAtIndex:[indexPath item]];
 }
 
+- (CKTransactionalComponentDataSourceItem *)objectAtPosition:(CKTransactionalComponentDataSourceItemPosition)position
+{
+  return [[_sections objectAtIndex:position.section] objectAtIndex:position.item];
+}
+
+- (CKTransactionalComponentDataSourceSectionItems)itemsInSection:(NSInteger)section
+{
+  return CKTransactionalComponentDataSourceSectionItems([_sections objectAtIndex:section]);
+}
+
+- (std::shared_ptr<const CKTransactionalComponentDataSourceScopeRootIndex>)scopeRootIndex
+{
+  // States are immutable, but may be used from the main thread and the work queue at once
+  CK::MutexLocker l(_scopeRootIndexMutex);
+  if (!_scopeRootIndex) {
+    CKTransactionalComponentDataSourceScopeRootIndex::PositionMap positions;
+    for (NSInteger section = 0; section < (NSInteger)[_sections count]; section++) {
+      const CKTransactionalComponentDataSourceSectionItems items([_sections objectAtIndex:section]);
+      for (auto it = items.begin(); it != items.end(); ++it) {
+        CKComponentScopeRoot *scopeRoot = [*it scopeRoot];
+        if (scopeRoot) {
+          positions.insert({[scopeRoot globalIdentifier], {section, (NSInteger)it.index()}});
+        }
+      }
+    }
+    _scopeRootIndex = std::make_shared<const CKTransactionalComponentDataSourceScopeRootIndex>(std::move(positions));
+  }
+  return _scopeRootIndex;
+}
+
+- (std::shared_ptr<const CKTransactionalComponentDataSourceScopeRootIndex>)builtScopeRootIndex
+{
+  CK::MutexLocker l(_scopeRootIndexMutex);
+  return _scopeRootIndex;
+}
+
 - (void)enumerateObjectsUsingBlock:(CKTransactionalComponentDataSourceEnumerator)block
 {
   if (block) {
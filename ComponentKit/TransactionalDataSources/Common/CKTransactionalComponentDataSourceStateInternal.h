@@ -10,6 +10,154 @@
 
 #import <ComponentKit/CKTransactionalComponentDataSourceState.h>
 
+#import <ComponentKit/CKComponentScopeTypes.h>
+
+#import <algorithm>
+#import <memory>
+#import <unordered_map>
+#import <vector>
+
+/** The position of an item in a state, without the allocation of an NSIndexPath. */
+struct CKTransactionalComponentDataSourceItemPosition {
+  NSInteger section;
+  NSInteger item;
+};
+
+/**
+ Maps the global identifier of the scope root of each item of a state to the position of the item.
+
+ A state built by a changeset doesn't index all of its items again: its index is layered over the index of the previous
+ state and only holds what the changeset changed, i.e. where the sections of the previous state went and the positions
+ of the items that were inserted, moved or shifted, or that were removed. Appending items to a section only indexes the
+ appended items; removing or inserting an item in the middle of a section indexes the items after it in that section.
+ Lookups go down the layers until one knows the item, so they cost up to depth() hash lookups.
+ */
+class CKTransactionalComponentDataSourceScopeRootIndex {
+public:
+  typedef std::unordered_map<CKComponentScopeRootIdentifier, CKTransactionalComponentDataSourceItemPosition> PositionMap;
+
+  /** An index of the given positions, e.g. of every item of a state. */
+  explicit CKTransactionalComponentDataSourceScopeRootIndex(PositionMap positions)
+  : _positions(std::move(positions)), _depth(1) {}
+
+  /**
+   An index layered over the index of a previous state.
+   @param base The index of the previous state.
+   @param sectionMap For every section of the previous state, the section it is in now or NSNotFound if it was removed.
+          Empty if no section was inserted or removed.
+   @param changedPositions The positions of the items whose position changed. Removed items have an NSNotFound section.
+   */
+  CKTransactionalComponentDataSourceScopeRootIndex(std::shared_ptr<const CKTransactionalComponentDataSourceScopeRootIndex> base,
+                                                   std::vector<NSInteger> sectionMap,
+                                                   PositionMap changedPositions)
+  : _base(std::move(base)), _sectionMap(std::move(sectionMap)), _positions(std::move(changedPositions)),
+    _depth(_base->depth() + 1) {}
+
+  /** Returns whether an item has the scope root with the given identifier, and if so sets position to its position. */
+  bool find(CKComponentScopeRootIdentifier identifier, CKTransactionalComponentDataSourceItemPosition &position) const
+  {
+    const auto it = _positions.find(identifier);
+    if (it != _positions.end()) {
+      position = it->second;
+      return position.section != NSNotFound;
+    }
+    if (!_base || !_base->find(identifier, position)) {
+      return false;
+    }
+    if (!_sectionMap.empty()) {
+      position.section = _sectionMap[position.section];
+    }
+    return position.section != NSNotFound;
+  }
+
+  /** The number of layers, including this one. */
+  NSUInteger depth() const { return _depth; }
+
+private:
+  std::shared_ptr<const CKTransactionalComponentDataSourceScopeRootIndex> _base;
+  std::vector<NSInteger> _sectionMap;
+  PositionMap _positions;
+  NSUInteger _depth;
+};
+
+/**
+ The items of one section of a state, for iterating over them without allocating an index path or sending a message
+ per item; the items are fast enumerated, a batch at a time.
+
+   for (CKTransactionalComponentDataSourceItem *item : [state itemsInSection:0]) { ... }
+
+ Iterators are input iterators: they can only be compared with end() and only go forward, which is all a range-based
+ for loop needs. index() returns the index in the section of the current item.
+ */
+class CKTransactionalComponentDataSourceSectionItems {
+public:
+  explicit CKTransactionalComponentDataSourceSectionItems(NSArray *items) : _items(items) {}
+
+  class const_iterator {
+  public:
+    const_iterator() : _items(nil), _state(), _count(0), _batchIndex(0), _index(0) {}
+    explicit const_iterator(NSArray *items) : _items(items), _state(), _count(0), _batchIndex(0), _index(0)
+    {
+      fetchBatch();
+    }
+    const_iterator(const const_iterator &other) { *this = other; }
+    const_iterator &operator=(const const_iterator &other)
+    {
+      _items = other._items;
+      _state = other._state;
+      _count = other._count;
+      _batchIndex = other._batchIndex;
+      _index = other._index;
+      std::copy(other._buffer, other._buffer + kBatchSize, _buffer);
+      // The batch may point into the buffer of the iterator being copied
+      if (other._state.itemsPtr == other._buffer) {
+        _state.itemsPtr = _buffer;
+      }
+      return *this;
+    }
+
+    CKTransactionalComponentDataSourceItem *operator*() const { return _state.itemsPtr[_batchIndex]; }
+
+    const_iterator &operator++()
+    {
+      _index++;
+      if (++_batchIndex == _count) {
+        fetchBatch();
+      }
+      return *this;
+    }
+
+    bool operator==(const const_iterator &other) const { return (_count == 0) == (other._count == 0); }
+    bool operator!=(const const_iterator &other) const { return !(*this == other); }
+
+    NSUInteger index() const { return _index; }
+
+  private:
+    static const NSUInteger kBatchSize = 16;
+
+    void fetchBatch()
+    {
+      _count = [_items countByEnumeratingWithState:&_state objects:_buffer count:kBatchSize];
+      _batchIndex = 0;
+    }
+
+    NSArray *_items;
+    NSFastEnumerationState _state;
+    __unsafe_unretained id _buffer[kBatchSize];
+    NSUInteger _count;
+    NSUInteger _batchIndex;
+    NSUInteger _index;
+  };
+
+  const_iterator begin() const { return const_iterator(_items); }
+  const_iterator end() const { return const_iterator(); }
+
+  NSUInteger size() const { return [_items count]; }
+
+private:
+  NSArray *_items;
+};
+
 /** Internal interface since this class is usually only created internally. */
 @interface CKTransactionalComponentDataSourceState ()
 
@@ -20,6 +168,38 @@
 - (instancetype)initWithConfiguration:(CKTransactionalComponentDataSourceConfiguration *)configuration
                              sections:(NSArray *)sections;
 
+/**
+ @param configuration The configuration used to generate this state object.
+ @param sections An NSArray of NSArrays of CKTransactionalComponentDataSourceItem.
+ @param scopeRootIndex The scope root index of the state, e.g. the one of a previous state if every item is at the same
+        position as in that state and has a scope root with the same global identifier, or one layered over it. Pass
+        nullptr to have the index built when it is first needed.
+ */
+- (instancetype)initWithConfiguration:(CKTransactionalComponentDataSourceConfiguration *)configuration
+                             sections:(NSArray *)sections
+                       scopeRootIndex:(std::shared_ptr<const CKTransactionalComponentDataSourceScopeRootIndex>)scopeRootIndex;
+
+/**
+ Sections are immutable, so states share the ones a modification did not change. Sharing is per section: changing a
+ single item still copies its whole section, so a modification costs the size of the sections it touches, which for a
+ long feed in a single section is the size of the feed.
+ */
 @property (nonatomic, copy, readonly) NSArray *sections;
 
+- (CKTransactionalComponentDataSourceItem *)objectAtPosition:(CKTransactionalComponentDataSourceItemPosition)position;
+
+- (CKTransactionalComponentDataSourceSectionItems)itemsInSection:(NSInteger)section;
+
+/**
+ The position of the item of every scope root, for finding the items that received state updates without scanning the
+ whole state. Built on first use, which takes a pass over every item, unless it was passed to the initializer.
+ */
+- (std::shared_ptr<const CKTransactionalComponentDataSourceScopeRootIndex>)scopeRootIndex;
+
+/**
+ The scope root index if it was passed to the initializer or already built, or nullptr; never builds it. Modifications
+ carry it over to the states they create with this, so that states that never receive a state update never build one.
+ */
+- (std::shared_ptr<const CKTransactionalComponentDataSourceScopeRootIndex>)builtScopeRootIndex;
+
 @end
@@ -10,7 +10,10 @@
 
 #import "CKTransactionalComponentDataSourceChangesetModification.h"
 
+#import <algorithm>
+#import <atomic>
 #import <map>
+#import <vector>
 
 #import "CKTransactionalComponentDataSourceConfigurationInternal.h"
 #import "CKTransactionalComponentDataSourceStateInternal.h"
@@ -22,11 +25,23 @@
 #import "CKComponentControllerEvents.h"
 #import "CKComponentBoundsAnimationPredicates.h"
 #import "CKComponentLayout.h"
+#import "CKComponentLayoutReuse.h"
 #import "CKComponentProvider.h"
 #import "CKComponentScopeFrame.h"
 #import "CKComponentScopeRoot.h"
 #import "CKComponentScopeRootFactory.h"
 
+/**
+ An item of the changeset to build: the model of an inserted or updated item, the scope root to build it in, and the
+ layout reuse state of the item it replaces, if any.
+ */
+struct CKTransactionalComponentDataSourceItemToBuild {
+  NSIndexPath *indexPath;
+  id model;
+  CKComponentScopeRoot *scopeRoot;
+  id layoutReuseState;
+};
+
 @implementation CKTransactionalComponentDataSourceChangesetModification
 {
   id<CKComponentStateListener> _stateListener;
@@ -52,24 +67,34 @@
   id<NSObject> context = [configuration context];
   const CKSizeRange sizeRange = [configuration sizeRange];
 
-  NSMutableArray *newSections = [NSMutableArray array];
-  [[oldState sections] enumerateObjectsUsingBlock:^(NSArray *items, NSUInteger sectionIdx, BOOL *sectionStop) {
-    [newSections addObject:[items mutableCopy]];
-  }];
+  // Sections start out as the immutable arrays of the old state; only the ones that change are copied
+  NSMutableArray *newSections = [[oldState sections] mutableCopy];
+  NSMutableIndexSet *mutableSections = [NSMutableIndexSet indexSet];
 
-  // Update items
+  // Build updated and inserted items up front; they don't depend on each other, so they can be built in parallel
+  __block std::vector<CKTransactionalComponentDataSourceItemToBuild> updatedItemsToBuild;
   [[_changeset updatedItems] enumerateKeysAndObjectsUsingBlock:^(NSIndexPath *indexPath, id model, BOOL *stop) {
-    NSMutableArray *section = newSections[indexPath.section];
-    CKTransactionalComponentDataSourceItem *oldItem = section[indexPath.item];
-
-    const CKBuildComponentResult result = CKBuildComponent([oldItem scopeRoot], {}, ^{
-      return [componentProvider componentForModel:model context:context];
-    });
-    const CKComponentLayout layout = CKComputeRootComponentLayout(result.component, sizeRange);
-
-    [section replaceObjectAtIndex:indexPath.item withObject:
-     [[CKTransactionalComponentDataSourceItem alloc] initWithLayout:layout model:model scopeRoot:result.scopeRoot boundsAnimation:result.boundsAnimation]];
+    CKTransactionalComponentDataSourceItem *oldItem = newSections[indexPath.section][indexPath.item];
+    updatedItemsToBuild.push_back({indexPath, model, [oldItem scopeRoot], [oldItem layoutReuseState]});
+  }];
+  __block std::vector<CKTransactionalComponentDataSourceItemToBuild> insertedItemsToBuild;
+  [[_changeset insertedItems] enumerateKeysAndObjectsUsingBlock:^(NSIndexPath *indexPath, id model, BOOL *stop) {
+    insertedItemsToBuild.push_back({indexPath, model, CKComponentScopeRootWithPredicates(_stateListener,
+                                                                                         configuration.componentPredicates,
+                                                                                         configuration.componentControllerPredicates), nil});
   }];
+  std::vector<CKTransactionalComponentDataSourceItemToBuild> itemsToBuild = updatedItemsToBuild;
+  itemsToBuild.insert(itemsToBuild.end(), insertedItemsToBuild.begin(), insertedItemsToBuild.end());
+  // A data source pinned to a thread builds everything on that thread
+  const NSUInteger parallelism = [configuration workThreadOverride] ? 1 : [configuration buildParallelism];
+  const std::vector<CKTransactionalComponentDataSourceItem *> builtItems =
+  buildItems(itemsToBuild, componentProvider, context, sizeRange, parallelism);
+
+  // Update items
+  for (size_t i = 0; i < updatedItemsToBuild.size(); i++) {
+    NSIndexPath *indexPath = updatedItemsToBuild[i].indexPath;
+    [mutableSection(newSections, indexPath.section, mutableSections) replaceObjectAtIndex:indexPath.item withObject:builtItems[i]];
+  }
 
   __block std::unordered_map<NSUInteger, std::map<NSUInteger, CKTransactionalComponentDataSourceItem *>> insertedItemsBySection;
   __block std::unordered_map<NSUInteger, NSMutableIndexSet *> removedItemsBySection;
@@ -97,27 +122,31 @@
     addRemovedIndexPath(removedItem);
   }
   for (const auto &it : removedItemsBySection) {
-    [[newSections objectAtIndex:it.first] removeObjectsAtIndexes:it.second];
+    [mutableSection(newSections, it.first, mutableSections) removeObjectsAtIndexes:it.second];
   }
 
   // Remove sections
   [newSections removeObjectsAtIndexes:[_changeset removedSections]];
+  [mutableSections removeIndexes:[_changeset removedSections]];
+  [[_changeset removedSections] enumerateIndexesWithOptions:NSEnumerationReverse usingBlock:^(NSUInteger idx, BOOL *stop) {
+    [mutableSections shiftIndexesStartingAtIndex:idx + 1 by:-1];
+  }];
 
   // Insert sections
   [newSections insertObjects:emptyMutableArrays([[_changeset insertedSections] count]) atIndexes:[_changeset insertedSections]];
+  [[_changeset insertedSections] enumerateIndexesUsingBlock:^(NSUInteger idx, BOOL *stop) {
+    [mutableSections shiftIndexesStartingAtIndex:idx by:1];
+    [mutableSections addIndex:idx];
+  }];
+
+  // Section indexes are final from here on, and so are the ones in mutableSections, which were shifted along with the
+  // sections: a section copied for updates or removals isn't copied again for insertions.
   
   // Insert items
-  [[_changeset insertedItems] enumerateKeysAndObjectsUsingBlock:^(NSIndexPath *indexPath, id model, BOOL *stop) {
-    const CKBuildComponentResult result =
-    CKBuildComponent(CKComponentScopeRootWithPredicates(_stateListener,
-                                                        configuration.componentPredicates,
-                                                        configuration.componentControllerPredicates), {}, ^{
-      return [componentProvider componentForModel:model context:context];
-    });
-    const CKComponentLayout layout = CKComputeRootComponentLayout(result.component, sizeRange);
-    insertedItemsBySection[indexPath.section][indexPath.item] =
-    [[CKTransactionalComponentDataSourceItem alloc] initWithLayout:layout model:model scopeRoot:result.scopeRoot boundsAnimation:result.boundsAnimation];
-  }];
+  for (size_t i = 0; i < insertedItemsToBuild.size(); i++) {
+    NSIndexPath *indexPath = insertedItemsToBuild[i].indexPath;
+    insertedItemsBySection[indexPath.section][indexPath.item] = builtItems[updatedItemsToBuild.size() + i];
+  }
   
   for (const auto &sectionIt : insertedItemsBySection) {
     NSMutableIndexSet *indexes = [NSMutableIndexSet indexSet];
@@ -127,12 +156,13 @@
       [indexes addIndex:itemIt.first];
       [items addObject:itemIt.second];
     }
-    [[newSections objectAtIndex:sectionIt.first] insertObjects:items atIndexes:indexes];
+    [mutableSection(newSections, sectionIt.first, mutableSections) insertObjects:items atIndexes:indexes];
   }
 
   CKTransactionalComponentDataSourceState *newState =
   [[CKTransactionalComponentDataSourceState alloc] initWithConfiguration:configuration
-                                                                sections:newSections];
+                                                                sections:newSections
+                                                          scopeRootIndex:scopeRootIndex(oldState, _changeset, newSections)];
 
   CKTransactionalComponentDataSourceAppliedChanges *appliedChanges =
   [[CKTransactionalComponentDataSourceAppliedChanges alloc] initWithUpdatedIndexPaths:[NSSet setWithArray:[[_changeset updatedItems] allKeys]]
@@ -152,6 +182,156 @@
   return [_changeset description];
 }
 
+static CKTransactionalComponentDataSourceItem *buildItem(const CKTransactionalComponentDataSourceItemToBuild &itemToBuild,
+                                                         Class<CKComponentProvider> componentProvider,
+                                                         id<NSObject> context,
+                                                         const CKSizeRange &sizeRange)
+{
+  id model = itemToBuild.model;
+  const CKBuildComponentResult result = CKBuildComponent(itemToBuild.scopeRoot, {}, ^{
+    return [componentProvider componentForModel:model context:context];
+  });
+  // Recorded so that the first state update of the item only lays out the path to the updated component
+  CKComponentLayoutReuse layoutReuse(itemToBuild.layoutReuseState);
+  const CKComponentLayout layout = CKComputeRootComponentLayout(result.component, sizeRange);
+  return [[CKTransactionalComponentDataSourceItem alloc] initWithLayout:layout
+                                                                  model:model
+                                                              scopeRoot:result.scopeRoot
+                                                        boundsAnimation:result.boundsAnimation
+                                                       layoutReuseState:layoutReuse.nextState()];
+}
+
+/**
+ Builds the items on at most `parallelism` threads at once, including the calling one. The returned items are in the
+ same order as itemsToBuild, whichever order they were built in.
+ */
+static std::vector<CKTransactionalComponentDataSourceItem *> buildItems(const std::vector<CKTransactionalComponentDataSourceItemToBuild> &itemsToBuild,
+                                                                        Class<CKComponentProvider> componentProvider,
+                                                                        id<NSObject> context,
+                                                                        const CKSizeRange &sizeRange,
+                                                                        NSUInteger parallelism)
+{
+  std::vector<CKTransactionalComponentDataSourceItem *> items(itemsToBuild.size());
+  const size_t workerCount = std::min<size_t>(parallelism, itemsToBuild.size());
+  if (workerCount <= 1) {
+    for (size_t i = 0; i < itemsToBuild.size(); i++) {
+      items[i] = buildItem(itemsToBuild[i], componentProvider, context, sizeRange);
+    }
+    return items;
+  }
+
+  // Each worker takes the next item that isn't being built yet, so a few slow items don't hold up the others
+  std::atomic<size_t> nextItem(0);
+  std::atomic<size_t> *nextItemPtr = &nextItem;
+  const std::vector<CKTransactionalComponentDataSourceItemToBuild> *itemsToBuildPtr = &itemsToBuild;
+  std::vector<CKTransactionalComponentDataSourceItem *> *itemsPtr = &items;
+  const CKSizeRange *sizeRangePtr = &sizeRange;
+  dispatch_apply(workerCount, dispatch_get_global_queue(qos_class_self(), 0), ^(size_t worker) {
+    for (size_t i = (*nextItemPtr)++; i < itemsToBuildPtr->size(); i = (*nextItemPtr)++) {
+      (*itemsPtr)[i] = buildItem((*itemsToBuildPtr)[i], componentProvider, context, *sizeRangePtr);
+    }
+  });
+  return items;
+}
+
+/** Past this many layers, the index of a new state is built from scratch when it is first needed instead. */
+static const NSUInteger kMaximumScopeRootIndexDepth = 8;
+
+/**
+ Returns the index of the old state carried over to the new one, or nullptr if the old state never built one. Updated
+ items keep their scope roots and positions; all other changes are indexed in a layer over the old index.
+ */
+static std::shared_ptr<const CKTransactionalComponentDataSourceScopeRootIndex> scopeRootIndex(CKTransactionalComponentDataSourceState *oldState,
+                                                                                              CKDataSourceChangeset *changeset,
+                                                                                              NSArray *newSections)
+{
+  const auto oldIndex = [oldState builtScopeRootIndex];
+  NSIndexSet *removedSections = [changeset removedSections];
+  NSIndexSet *insertedSections = [changeset insertedSections];
+  if (!oldIndex || ([[changeset removedItems] count] == 0 && [removedSections count] == 0
+                    && [[changeset movedItems] count] == 0 && [insertedSections count] == 0
+                    && [[changeset insertedItems] count] == 0)) {
+    return oldIndex;
+  }
+  if (oldIndex->depth() >= kMaximumScopeRootIndexDepth) {
+    return nullptr;
+  }
+
+  // Where each section of the old state went: the remaining ones keep their order around the inserted ones
+  std::vector<NSInteger> sectionMap;
+  if ([removedSections count] > 0 || [insertedSections count] > 0) {
+    sectionMap.resize([oldState numberOfSections]);
+    NSUInteger newSection = 0;
+    for (NSUInteger oldSection = 0; oldSection < sectionMap.size(); oldSection++) {
+      if ([removedSections containsIndex:oldSection]) {
+        sectionMap[oldSection] = NSNotFound;
+      } else {
+        while ([insertedSections containsIndex:newSection]) {
+          newSection++;
+        }
+        sectionMap[oldSection] = newSection++;
+      }
+    }
+  }
+  const auto newSectionOf = [&sectionMap](NSInteger oldSection) {
+    return sectionMap.empty() ? oldSection : sectionMap[oldSection];
+  };
+
+  // Items before the first removal (in old indexes) and the first insertion (in new indexes) of a section don't move
+  CKTransactionalComponentDataSourceScopeRootIndex::PositionMap changedPositions;
+  std::unordered_map<NSInteger, NSInteger> firstChangedItems;
+  const auto addChange = [&firstChangedItems](NSInteger section, NSInteger item) {
+    const auto it = firstChangedItems.insert({section, item}).first;
+    it->second = std::min(it->second, item);
+  };
+  const auto addRemoval = [&](NSIndexPath *indexPath) {
+    const NSInteger section = newSectionOf(indexPath.section);
+    if (section != NSNotFound) {
+      addChange(section, indexPath.item);
+    }
+  };
+  for (NSIndexPath *indexPath in [changeset removedItems]) {
+    addRemoval(indexPath);
+    CKComponentScopeRoot *scopeRoot = [[oldState objectAtIndexPath:indexPath] scopeRoot];
+    if (scopeRoot) {
+      changedPositions[[scopeRoot globalIdentifier]] = {NSNotFound, NSNotFound};
+    }
+  }
+  [[changeset movedItems] enumerateKeysAndObjectsUsingBlock:^(NSIndexPath *from, NSIndexPath *to, BOOL *stop) {
+    addRemoval(from);
+    addChange(to.section, to.item);
+  }];
+  for (NSIndexPath *indexPath in [changeset insertedItems]) {
+    addChange(indexPath.section, indexPath.item);
+  }
+
+  // Moved items end up after the first change of their new section, so they are indexed here too
+  for (const auto &it : firstChangedItems) {
+    NSArray *items = newSections[it.first];
+    for (NSInteger item = it.second; item < (NSInteger)[items count]; item++) {
+      CKComponentScopeRoot *scopeRoot = [items[item] scopeRoot];
+      if (scopeRoot) {
+        changedPositions[[scopeRoot globalIdentifier]] = {it.first, item};
+      }
+    }
+  }
+  return std::make_shared<const CKTransactionalComponentDataSourceScopeRootIndex>(oldIndex, std::move(sectionMap),
+                                                                                 std::move(changedPositions));
+}
+
+/**
+ Returns the section at the index, replacing it with a mutable copy first unless mutableSections says it already is one.
+ Sections that are never modified stay the arrays of the old state, which the new state shares instead of copying.
+ */
+static NSMutableArray *mutableSection(NSMutableArray *sections, NSUInteger index, NSMutableIndexSet *mutableSections)
+{
+  if (![mutableSections containsIndex:index]) {
+    sections[index] = [sections[index] mutableCopy];
+    [mutableSections addIndex:index];
+  }
+  return sections[index];
+}
+
 static NSArray *emptyMutableArrays(NSUInteger count)
 {
   NSMutableArray *arrays = [NSMutableArray array];
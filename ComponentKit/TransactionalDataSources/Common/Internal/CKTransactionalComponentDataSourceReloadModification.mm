@@ -17,6 +17,7 @@
 #import "CKTransactionalComponentDataSourceAppliedChanges.h"
 #import "CKBuildComponent.h"
 #import "CKComponentLayout.h"
+#import "CKComponentLayoutReuse.h"
 #import "CKComponentProvider.h"
 #import "CKComponentScopeFrame.h"
 #import "CKComponentScopeRoot.h"
@@ -43,25 +44,31 @@
 
   NSMutableArray *newSections = [NSMutableArray array];
   NSMutableSet *updatedIndexPaths = [NSMutableSet set];
-  [[oldState sections] enumerateObjectsUsingBlock:^(NSArray *items, NSUInteger sectionIdx, BOOL *sectionStop) {
-    NSMutableArray *newItems = [NSMutableArray array];
-    [items enumerateObjectsUsingBlock:^(CKTransactionalComponentDataSourceItem *item, NSUInteger itemIdx, BOOL *itemStop) {
-      [updatedIndexPaths addObject:[NSIndexPath indexPathForItem:itemIdx inSection:sectionIdx]];
+  for (NSInteger sectionIdx = 0; sectionIdx < [oldState numberOfSections]; sectionIdx++) {
+    const CKTransactionalComponentDataSourceSectionItems items = [oldState itemsInSection:sectionIdx];
+    NSMutableArray *newItems = [NSMutableArray arrayWithCapacity:items.size()];
+    for (auto it = items.begin(); it != items.end(); ++it) {
+      CKTransactionalComponentDataSourceItem *item = *it;
+      [updatedIndexPaths addObject:[NSIndexPath indexPathForItem:it.index() inSection:sectionIdx]];
       const CKBuildComponentResult result = CKBuildComponent([item scopeRoot], {}, ^{
         return [componentProvider componentForModel:[item model] context:context];
       });
+      CKComponentLayoutReuse layoutReuse([item layoutReuseState]);
       const CKComponentLayout layout = CKComputeRootComponentLayout(result.component, sizeRange);
       [newItems addObject:[[CKTransactionalComponentDataSourceItem alloc] initWithLayout:layout
                                                                                    model:[item model]
                                                                                scopeRoot:result.scopeRoot
-                                                                         boundsAnimation:result.boundsAnimation]];
-    }];
+                                                                         boundsAnimation:result.boundsAnimation
+                                                                        layoutReuseState:layoutReuse.nextState()]];
+    }
     [newSections addObject:newItems];
-  }];
+  }
 
+  // Every item is rebuilt in place with its scope root, so the index of the old state still applies
   CKTransactionalComponentDataSourceState *newState =
   [[CKTransactionalComponentDataSourceState alloc] initWithConfiguration:configuration
-                                                                sections:newSections];
+                                                                sections:newSections
+                                                          scopeRootIndex:[oldState builtScopeRootIndex]];
 
   CKTransactionalComponentDataSourceAppliedChanges *appliedChanges =
   [[CKTransactionalComponentDataSourceAppliedChanges alloc] initWithUpdatedIndexPaths:updatedIndexPaths
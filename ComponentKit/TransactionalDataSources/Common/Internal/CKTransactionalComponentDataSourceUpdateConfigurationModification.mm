@@ -17,6 +17,7 @@
 #import "CKTransactionalComponentDataSourceAppliedChanges.h"
 #import "CKBuildComponent.h"
 #import "CKComponentLayout.h"
+#import "CKComponentLayoutReuse.h"
 #import "CKComponentProvider.h"
 #import "CKComponentScopeFrame.h"
 #import "CKComponentScopeRoot.h"
@@ -55,12 +56,14 @@
       [updatedIndexPaths addObject:[NSIndexPath indexPathForItem:itemIdx inSection:sectionIdx]];
 
       CKTransactionalComponentDataSourceItem *newItem;
+      CKComponentLayoutReuse layoutReuse([item layoutReuseState]);
       if (onlySizeRangeChanged) {
         const CKComponentLayout layout = CKComputeRootComponentLayout(item.layout.component, sizeRange);
         newItem = [[CKTransactionalComponentDataSourceItem alloc] initWithLayout:layout
                                                                            model:[item model]
                                                                        scopeRoot:[item scopeRoot]
-                                                                 boundsAnimation:[item boundsAnimation]];
+                                                                 boundsAnimation:[item boundsAnimation]
+                                                                layoutReuseState:layoutReuse.nextState()];
       } else {
         const CKBuildComponentResult result = CKBuildComponent([item scopeRoot], {}, ^{
           return [componentProvider componentForModel:[item model] context:context];
@@ -69,7 +72,8 @@
         newItem = [[CKTransactionalComponentDataSourceItem alloc] initWithLayout:layout
                                                                            model:[item model]
                                                                        scopeRoot:result.scopeRoot
-                                                                 boundsAnimation:result.boundsAnimation];
+                                                                 boundsAnimation:result.boundsAnimation
+                                                                layoutReuseState:layoutReuse.nextState()];
       }
 
       [newItems addObject:newItem];
@@ -77,9 +81,11 @@
     [newSections addObject:newItems];
   }];
 
+  // Every item is rebuilt in place with its scope root, so the index of the old state still applies
   CKTransactionalComponentDataSourceState *newState =
   [[CKTransactionalComponentDataSourceState alloc] initWithConfiguration:_configuration
-                                                                sections:newSections];
+                                                                sections:newSections
+                                                          scopeRootIndex:[oldState builtScopeRootIndex]];
 
   CKTransactionalComponentDataSourceAppliedChanges *appliedChanges =
   [[CKTransactionalComponentDataSourceAppliedChanges alloc] initWithUpdatedIndexPaths:updatedIndexPaths
@@ -10,6 +10,9 @@
 
 #import "CKTransactionalComponentDataSourceUpdateStateModification.h"
 
+#import <algorithm>
+#import <vector>
+
 #import "CKTransactionalComponentDataSourceConfiguration.h"
 #import "CKTransactionalComponentDataSourceStateInternal.h"
 #import "CKTransactionalComponentDataSourceChange.h"
@@ -17,6 +20,7 @@
 #import "CKTransactionalComponentDataSourceAppliedChanges.h"
 #import "CKBuildComponent.h"
 #import "CKComponentLayout.h"
+#import "CKComponentLayoutReuse.h"
 #import "CKComponentProvider.h"
 #import "CKComponentScopeFrame.h"
 #import "CKComponentScopeRoot.h"
@@ -41,38 +45,58 @@
   id<NSObject> context = [configuration context];
   const CKSizeRange sizeRange = [configuration sizeRange];
 
-  NSMutableArray *newSections = [NSMutableArray array];
+  // Look up the items with state updates instead of scanning the whole state, and update them in index order
+  const auto scopeRootIndex = [oldState scopeRootIndex];
+  std::vector<std::pair<CKTransactionalComponentDataSourceItemPosition, CKComponentStateUpdatesMap::const_iterator>> itemsToUpdate;
+  for (auto it = _stateUpdates.begin(); it != _stateUpdates.end(); ++it) {
+    CKTransactionalComponentDataSourceItemPosition position;
+    // The item may have been removed since the update was enqueued
+    if (scopeRootIndex->find(it->first, position)) {
+      itemsToUpdate.push_back({position, it});
+    }
+  }
+  std::sort(itemsToUpdate.begin(), itemsToUpdate.end(), [](const auto &a, const auto &b) {
+    return a.first.section < b.first.section || (a.first.section == b.first.section && a.first.item < b.first.item);
+  });
+
+  // Sections without updated items are shared with the old state
+  NSMutableArray *newSections = [[oldState sections] mutableCopy];
+  NSMutableIndexSet *mutableSections = [NSMutableIndexSet indexSet];
   NSMutableSet *updatedIndexPaths = [NSMutableSet set];
-  __block CKComponentScopeRootIdentifier globalIdentifier = 0;
-  [[oldState sections] enumerateObjectsUsingBlock:^(NSArray *items, NSUInteger sectionIdx, BOOL *sectionStop) {
-    NSMutableArray *newItems = [NSMutableArray array];
-    [items enumerateObjectsUsingBlock:^(CKTransactionalComponentDataSourceItem *item, NSUInteger itemIdx, BOOL *itemStop) {
-      const auto stateUpdatesForItem = _stateUpdates.find([[item scopeRoot] globalIdentifier]);
-      if (stateUpdatesForItem == _stateUpdates.end()) {
-        [newItems addObject:item];
-      } else {
-        const auto stateUpdateMap = stateUpdatesForItem->second;
-        const auto stateUpdate = stateUpdateMap.begin();
-        if (stateUpdate != stateUpdateMap.end()) {
-          globalIdentifier = stateUpdate->first;
-        }
-        [updatedIndexPaths addObject:[NSIndexPath indexPathForItem:itemIdx inSection:sectionIdx]];
-        const CKBuildComponentResult result = CKBuildComponent([item scopeRoot], stateUpdatesForItem->second, ^{
-          return [componentProvider componentForModel:[item model] context:context];
-        });
-        const CKComponentLayout layout = CKComputeRootComponentLayout(result.component, sizeRange);
-        [newItems addObject:[[CKTransactionalComponentDataSourceItem alloc] initWithLayout:layout
-                                                                                     model:[item model]
-                                                                                 scopeRoot:result.scopeRoot
-                                                                           boundsAnimation:result.boundsAnimation]];
-      }
-    }];
-    [newSections addObject:newItems];
-  }];
+  CKComponentScopeRootIdentifier globalIdentifier = 0;
+  for (const auto &itemToUpdate : itemsToUpdate) {
+    const CKTransactionalComponentDataSourceItemPosition position = itemToUpdate.first;
+    const auto &stateUpdateMap = itemToUpdate.second->second;
+    CKTransactionalComponentDataSourceItem *item = [oldState objectAtPosition:position];
+    const auto stateUpdate = stateUpdateMap.begin();
+    if (stateUpdate != stateUpdateMap.end()) {
+      globalIdentifier = stateUpdate->first;
+    }
+    [updatedIndexPaths addObject:[NSIndexPath indexPathForItem:position.item inSection:position.section]];
+    const CKBuildComponentResult result = CKBuildComponent([item scopeRoot], stateUpdateMap, ^{
+      return [componentProvider componentForModel:[item model] context:context];
+    });
+    // Only the components on the path to the updated ones were rebuilt; reuse the layouts of the others
+    CKComponentLayoutReuse layoutReuse([item layoutReuseState]);
+    const CKComponentLayout layout = CKComputeRootComponentLayout(result.component, sizeRange);
+    CKTransactionalComponentDataSourceItem *newItem =
+    [[CKTransactionalComponentDataSourceItem alloc] initWithLayout:layout
+                                                             model:[item model]
+                                                         scopeRoot:result.scopeRoot
+                                                   boundsAnimation:result.boundsAnimation
+                                                  layoutReuseState:layoutReuse.nextState()];
+    if (![mutableSections containsIndex:position.section]) {
+      newSections[position.section] = [newSections[position.section] mutableCopy];
+      [mutableSections addIndex:position.section];
+    }
+    [newSections[position.section] replaceObjectAtIndex:position.item withObject:newItem];
+  }
 
+  // Rebuilt items keep their position and the identifier of their scope root, so the index is still valid
   CKTransactionalComponentDataSourceState *newState =
   [[CKTransactionalComponentDataSourceState alloc] initWithConfiguration:configuration
-                                                                sections:newSections];
+                                                                sections:newSections
+                                                          scopeRootIndex:scopeRootIndex];
 
   CKTransactionalComponentDataSourceAppliedChanges *appliedChanges =
   [[CKTransactionalComponentDataSourceAppliedChanges alloc] initWithUpdatedIndexPaths:updatedIndexPaths
@@ -131,4 +131,60 @@ namespace CK {
 
   typedef Locker<StaticMutex> StaticMutexLocker;
 
+  /**
+   Reader/writer lock. Exposes lock()/unlock() for exclusive access (so it can be used with Locker or std::lock_guard)
+   and lock_shared()/unlock_shared() for concurrent readers (use with SharedLocker).
+   */
+  struct RWMutex
+  {
+    RWMutex () {
+      CK_THREAD_ASSERT_ON_ERROR(pthread_rwlock_init (&_l, NULL));
+    }
+
+    ~RWMutex () {
+      CK_THREAD_ASSERT_ON_ERROR(pthread_rwlock_destroy (&_l));
+    }
+
+    RWMutex (const RWMutex&) = delete;
+    RWMutex &operator=(const RWMutex&) = delete;
+
+    void lock () {
+      CK_THREAD_ASSERT_ON_ERROR(pthread_rwlock_wrlock (&_l));
+    }
+
+    void unlock () {
+      CK_THREAD_ASSERT_ON_ERROR(pthread_rwlock_unlock (&_l));
+    }
+
+    void lock_shared () {
+      CK_THREAD_ASSERT_ON_ERROR(pthread_rwlock_rdlock (&_l));
+    }
+
+    void unlock_shared () {
+      CK_THREAD_ASSERT_ON_ERROR(pthread_rwlock_unlock (&_l));
+    }
+
+  private:
+    pthread_rwlock_t _l;
+  };
+
+  template<class T>
+  class SharedLocker
+  {
+    T &_l;
+
+  public:
+    SharedLocker (T &l) CK_NOTHROW : _l (l) {
+      _l.lock_shared ();
+    }
+
+    ~SharedLocker () {
+      _l.unlock_shared ();
+    }
+
+    // non-copyable.
+    SharedLocker(const SharedLocker<T>&) = delete;
+    SharedLocker &operator=(const SharedLocker<T>&) = delete;
+  };
+
 } // namespace CK
@@ -0,0 +1,89 @@
+/*
+ *  Copyright (c) 2014-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+
+#import <XCTest/XCTest.h>
+
+#import <ComponentKit/CKComponent.h>
+#import <ComponentKit/CKComponentSubclass.h>
+
+@interface CKLayoutCachingTestComponent : CKComponent
+@property (nonatomic, assign, readonly) NSUInteger computeCount;
+@end
+
+@implementation CKLayoutCachingTestComponent
+
++ (NSUInteger)layoutCacheCapacity
+{
+  return 2;
+}
+
+- (CKComponentLayout)computeLayoutThatFits:(CKSizeRange)constrainedSize
+{
+  _computeCount++;
+  return [super computeLayoutThatFits:constrainedSize];
+}
+
+@end
+
+@interface CKComponentLayoutCacheTests : XCTestCase
+@end
+
+@implementation CKComponentLayoutCacheTests
+
+- (void)testLayingOutAgainWithTheSameSizeRangeAndParentSizeReturnsTheCachedLayout
+{
+  CKLayoutCachingTestComponent *component = [CKLayoutCachingTestComponent newWithView:{} size:{}];
+  const CKComponentLayout first = [component layoutThatFits:{{10, 10}, {100, 100}} parentSize:kCKComponentParentSizeUndefined];
+  const CKComponentLayout second = [component layoutThatFits:{{10, 10}, {100, 100}} parentSize:kCKComponentParentSizeUndefined];
+  XCTAssertEqual(component.computeCount, 1u);
+  XCTAssertTrue(CGSizeEqualToSize(first.size, second.size));
+}
+
+- (void)testADifferentParentSizeIsNotACacheHit
+{
+  CKLayoutCachingTestComponent *component = [CKLayoutCachingTestComponent newWithView:{} size:{}];
+  [component layoutThatFits:{{10, 10}, {100, 100}} parentSize:kCKComponentParentSizeUndefined];
+  [component layoutThatFits:{{10, 10}, {100, 100}} parentSize:{100, 100}];
+  XCTAssertEqual(component.computeCount, 2u);
+}
+
+- (void)testOnlyTheMostRecentlyUsedLayoutsAreKept
+{
+  CKLayoutCachingTestComponent *component = [CKLayoutCachingTestComponent newWithView:{} size:{}];
+  [component layoutThatFits:{{10, 10}, {10, 10}} parentSize:kCKComponentParentSizeUndefined];
+  [component layoutThatFits:{{20, 20}, {20, 20}} parentSize:kCKComponentParentSizeUndefined];
+  // Using the first layout again makes the second one the least recently used
+  [component layoutThatFits:{{10, 10}, {10, 10}} parentSize:kCKComponentParentSizeUndefined];
+  [component layoutThatFits:{{30, 30}, {30, 30}} parentSize:kCKComponentParentSizeUndefined];
+  XCTAssertEqual(component.computeCount, 3u);
+
+  [component layoutThatFits:{{10, 10}, {10, 10}} parentSize:kCKComponentParentSizeUndefined];
+  XCTAssertEqual(component.computeCount, 3u);
+  [component layoutThatFits:{{20, 20}, {20, 20}} parentSize:kCKComponentParentSizeUndefined];
+  XCTAssertEqual(component.computeCount, 4u);
+}
+
+- (void)testCachedLayoutsDoNotKeepTheirComponentAlive
+{
+  __weak CKLayoutCachingTestComponent *weakComponent;
+  @autoreleasepool {
+    CKLayoutCachingTestComponent *component = [CKLayoutCachingTestComponent newWithView:{} size:{}];
+    [component layoutThatFits:{{10, 10}, {100, 100}} parentSize:kCKComponentParentSizeUndefined];
+    weakComponent = component;
+  }
+  XCTAssertNil(weakComponent);
+}
+
+- (void)testComponentsDoNotCacheLayoutsByDefault
+{
+  XCTAssertEqual([CKComponent layoutCacheCapacity], 0u);
+}
+
+@end
@@ -0,0 +1,111 @@
+/*
+ *  Copyright (c) 2014-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+
+#import <XCTest/XCTest.h>
+
+#import <ComponentKit/CKComponent.h>
+#import <ComponentKit/CKCompositeComponent.h>
+#import <ComponentKit/ComponentLayoutContext.h>
+#import <ComponentKit/ComponentLayoutProfiler.h>
+
+#import <vector>
+
+struct CKRecordedLayoutEvent {
+  BOOL start;
+  Class componentClass;
+  CFTimeInterval inclusiveTime;
+  CFTimeInterval exclusiveTime;
+};
+
+class CKRecordingLayoutListener : public CK::Component::LayoutListener {
+public:
+  void layoutWillStart(Class componentClass, const CKSizeRange &sizeRange) override
+  {
+    events.push_back({YES, componentClass, 0, 0});
+  }
+
+  void layoutDidEnd(Class componentClass,
+                    const CKSizeRange &sizeRange,
+                    CFTimeInterval inclusiveTime,
+                    CFTimeInterval exclusiveTime) override
+  {
+    events.push_back({NO, componentClass, inclusiveTime, exclusiveTime});
+  }
+
+  std::vector<CKRecordedLayoutEvent> events;
+};
+
+@interface CKComponentLayoutProfilingTests : XCTestCase
+@end
+
+@implementation CKComponentLayoutProfilingTests
+
+- (void)tearDown
+{
+  CK::Component::LayoutContext::setListener(nullptr);
+  [super tearDown];
+}
+
+- (void)testListenerIsNotifiedOfNestedLayoutsWithTheirChildrenExcludedFromExclusiveTime
+{
+  CKRecordingLayoutListener listener;
+  CK::Component::LayoutContext::setListener(&listener);
+  CKComputeRootComponentLayout([CKCompositeComponent newWithComponent:[CKComponent new]], {{0, 0}, {100, 100}});
+  CK::Component::LayoutContext::setListener(nullptr);
+
+  const auto &events = listener.events;
+  XCTAssertEqual(events.size(), 4u);
+  XCTAssertTrue(events[0].start && events[0].componentClass == [CKCompositeComponent class]);
+  XCTAssertTrue(events[1].start && events[1].componentClass == [CKComponent class]);
+  XCTAssertTrue(!events[2].start && events[2].componentClass == [CKComponent class]);
+  XCTAssertTrue(!events[3].start && events[3].componentClass == [CKCompositeComponent class]);
+  XCTAssertEqualWithAccuracy(events[2].exclusiveTime, events[2].inclusiveTime, 1e-9);
+  XCTAssertEqualWithAccuracy(events[3].exclusiveTime, events[3].inclusiveTime - events[2].inclusiveTime, 1e-9);
+}
+
+- (void)testRemovedListenerIsNoLongerNotified
+{
+  CKRecordingLayoutListener listener;
+  CK::Component::LayoutContext::setListener(&listener);
+  CKComputeRootComponentLayout([CKComponent new], {{0, 0}, {100, 100}});
+  XCTAssertEqual(listener.events.size(), 2u);
+
+  CK::Component::LayoutContext::setListener(nullptr);
+  listener.events.clear();
+  CKComputeRootComponentLayout([CKComponent new], {{0, 0}, {100, 100}});
+  XCTAssertTrue(listener.events.empty());
+}
+
+- (void)testProfilerAggregatesLayoutsPerClass
+{
+  CK::Component::LayoutProfiler profiler;
+  CK::Component::LayoutContext::setListener(&profiler);
+  CKComputeRootComponentLayout([CKCompositeComponent newWithComponent:[CKComponent new]], {{0, 0}, {100, 100}});
+  CKComputeRootComponentLayout([CKComponent new], {{0, 0}, {100, 100}});
+  CK::Component::LayoutContext::setListener(nullptr);
+
+  const auto statistics = profiler.statistics();
+  XCTAssertEqual(statistics.size(), 2u);
+  for (const auto &classStatistics : statistics) {
+    const NSUInteger expectedCount = classStatistics.componentClass == [CKComponent class] ? 2 : 1;
+    XCTAssertEqual(classStatistics.count, expectedCount);
+    NSUInteger histogramCount = 0;
+    for (NSUInteger bucketCount : classStatistics.exclusiveTimeHistogram) {
+      histogramCount += bucketCount;
+    }
+    XCTAssertEqual(histogramCount, expectedCount);
+  }
+  XCTAssertGreaterThanOrEqual(statistics[0].exclusiveTime, statistics[1].exclusiveTime);
+
+  profiler.reset();
+  XCTAssertTrue(profiler.statistics().empty());
+}
+
+@end
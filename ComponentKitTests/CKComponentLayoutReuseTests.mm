@@ -0,0 +1,101 @@
+/*
+ *  Copyright (c) 2014-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+
+#import <XCTest/XCTest.h>
+
+#import <ComponentKit/CKComponent.h>
+#import <ComponentKit/CKComponentLayoutReuse.h>
+#import <ComponentKit/CKComponentSubclass.h>
+#import <ComponentKit/CKCompositeComponent.h>
+
+@interface CKLayoutReuseTestComponent : CKComponent
+@property (nonatomic, assign, readonly) NSUInteger computeCount;
+@end
+
+@implementation CKLayoutReuseTestComponent
+
+- (CKComponentLayout)computeLayoutThatFits:(CKSizeRange)constrainedSize
+{
+  _computeCount++;
+  return [super computeLayoutThatFits:constrainedSize];
+}
+
+@end
+
+@interface CKComponentLayoutReuseTests : XCTestCase
+@end
+
+@implementation CKComponentLayoutReuseTests
+
+static id layOutWithReuse(CKComponent *component, const CKSizeRange &sizeRange, id previousState, CKComponentLayout *layout)
+{
+  CKComponentLayoutReuse reuse(previousState);
+  *layout = CKComputeRootComponentLayout(component, sizeRange);
+  return reuse.nextState();
+}
+
+- (void)testRebuiltParentReusesTheLayoutOfAChildThatWasNotRebuilt
+{
+  CKLayoutReuseTestComponent *child = [CKLayoutReuseTestComponent newWithView:{} size:{}];
+  CKComponentLayout layout;
+  id state = layOutWithReuse([CKCompositeComponent newWithComponent:child], {{10, 10}, {100, 100}}, nil, &layout);
+
+  CKComponent *rebuiltParent = [CKCompositeComponent newWithComponent:child];
+  layOutWithReuse(rebuiltParent, {{10, 10}, {100, 100}}, state, &layout);
+  XCTAssertEqual(child.computeCount, 1u);
+  XCTAssertEqual(layout.component, rebuiltParent);
+  XCTAssertEqual(layout.children->front().layout.component, child);
+}
+
+- (void)testADifferentSizeRangeIsLaidOutAgain
+{
+  CKLayoutReuseTestComponent *component = [CKLayoutReuseTestComponent newWithView:{} size:{}];
+  CKComponentLayout layout;
+  id state = layOutWithReuse(component, {{10, 10}, {100, 100}}, nil, &layout);
+  layOutWithReuse(component, {{20, 20}, {100, 100}}, state, &layout);
+  XCTAssertEqual(component.computeCount, 2u);
+}
+
+- (void)testLayoutsOfDescendantsOfAReusedLayoutCanBeReusedAgain
+{
+  CKLayoutReuseTestComponent *grandchild = [CKLayoutReuseTestComponent newWithView:{} size:{}];
+  CKComponent *child = [CKCompositeComponent newWithComponent:grandchild];
+  CKComponentLayout layout;
+  id state = layOutWithReuse([CKCompositeComponent newWithComponent:child], {{10, 10}, {100, 100}}, nil, &layout);
+  // The child is reused as a whole, so the grandchild isn't asked for a layout at all
+  state = layOutWithReuse([CKCompositeComponent newWithComponent:child], {{10, 10}, {100, 100}}, state, &layout);
+  layOutWithReuse([CKCompositeComponent newWithComponent:grandchild], {{10, 10}, {100, 100}}, state, &layout);
+  XCTAssertEqual(grandchild.computeCount, 1u);
+}
+
+- (void)testLayoutsOfDescendantsCanStillBeReusedAfterManyPassesThatReuseTheirAncestor
+{
+  CKLayoutReuseTestComponent *grandchild = [CKLayoutReuseTestComponent newWithView:{} size:{}];
+  CKComponent *child = [CKCompositeComponent newWithComponent:grandchild];
+  CKComponentLayout layout;
+  id state = nil;
+  // More passes than states are chained before they are compacted
+  for (NSUInteger i = 0; i < 20; i++) {
+    state = layOutWithReuse([CKCompositeComponent newWithComponent:child], {{10, 10}, {100, 100}}, state, &layout);
+  }
+  layOutWithReuse([CKCompositeComponent newWithComponent:grandchild], {{10, 10}, {100, 100}}, state, &layout);
+  XCTAssertEqual(grandchild.computeCount, 1u);
+}
+
+- (void)testLayoutsAreNotReusedWithoutAPreviousState
+{
+  CKLayoutReuseTestComponent *component = [CKLayoutReuseTestComponent newWithView:{} size:{}];
+  CKComputeRootComponentLayout(component, {{10, 10}, {100, 100}});
+  CKComponentLayout layout;
+  layOutWithReuse(component, {{10, 10}, {100, 100}}, nil, &layout);
+  XCTAssertEqual(component.computeCount, 2u);
+}
+
+@end
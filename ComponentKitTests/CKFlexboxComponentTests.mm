@@ -10,7 +10,9 @@
 
 #import <XCTest/XCTest.h>
 
+#import <ComponentKit/CKComponentSubclass.h>
 #import <ComponentKit/CKFlexboxComponent.h>
+#import <ComponentKit/ComponentLayoutContext.h>
 
 #import "yoga/Yoga.h"
 
@@ -18,6 +20,24 @@
 - (YGNodeRef)ygNode:(CKSizeRange)constrainedSize;
 @end
 
+/** Grows taller as it gets narrower, like wrapping text, and records how and how often it was measured */
+@interface CKFlexboxParallelTestComponent : CKComponent
+@property (atomic, copy, readonly) NSString *layoutStackDescription;
+@property (atomic, assign, readonly) NSUInteger layoutCount;
+@end
+
+@implementation CKFlexboxParallelTestComponent
+
+- (CKComponentLayout)computeLayoutThatFits:(CKSizeRange)constrainedSize
+{
+  _layoutStackDescription = [CK::Component::LayoutContext::currentStackDescription() copy];
+  _layoutCount++;
+  const CGFloat width = constrainedSize.max.width;
+  return {self, constrainedSize.clamp({width, ceil(10000 / width)})};
+}
+
+@end
+
 @interface CKFlexboxComponentTests : XCTestCase
 @end
 
@@ -227,4 +247,83 @@
   XCTAssertEqual(YGNodeStyleGetMargin(childNode, YGEdgeBottom).value, 10);
 }
 
+- (void)testParallelMeasurementProducesTheSameLayoutAsSerialMeasurement
+{
+  NSMutableArray<CKFlexboxParallelTestComponent *> *parallelChildren = [NSMutableArray array];
+  CKFlexboxComponent *(^stack)(BOOL, NSMutableArray *) = ^(BOOL parallel, NSMutableArray *children) {
+    for (NSUInteger i = 0; i < 4; i++) {
+      [children addObject:[CKFlexboxParallelTestComponent newWithView:{} size:{}]];
+    }
+    return [CKFlexboxComponent newWithView:{} size:{} style:{
+      .alignItems = CKFlexboxAlignItemsStretch,
+      .spacing = 5,
+      .padding = {.start = 10, .end = 20},
+      .measureChildrenInParallel = parallel,
+    }
+    children:{
+      {children[0]},
+      {children[1], .margin = {.start = 30}},
+      {children[2], .padding = {.end = 40}},
+      {children[3], .alignSelf = CKFlexboxAlignSelfStart},
+    }];
+  };
+
+  const CKSizeRange sizeRange = {{300, 0}, {300, INFINITY}};
+  const CKComponentLayout serialLayout = [stack(NO, [NSMutableArray array]) layoutThatFits:sizeRange parentSize:kCKComponentParentSizeUndefined];
+  const CKComponentLayout parallelLayout = [stack(YES, parallelChildren) layoutThatFits:sizeRange parentSize:kCKComponentParentSizeUndefined];
+
+  XCTAssertTrue(CGSizeEqualToSize(serialLayout.size, parallelLayout.size));
+  XCTAssertEqual(serialLayout.children->size(), parallelLayout.children->size());
+  for (size_t i = 0; i < serialLayout.children->size(); i++) {
+    const CKComponentLayoutChild &serialChild = serialLayout.children->at(i);
+    const CKComponentLayoutChild &parallelChild = parallelLayout.children->at(i);
+    XCTAssertTrue(CGPointEqualToPoint(serialChild.position, parallelChild.position));
+    XCTAssertTrue(CGSizeEqualToSize(serialChild.layout.size, parallelChild.layout.size));
+  }
+
+  for (CKFlexboxParallelTestComponent *child in parallelChildren) {
+    // Children measured on other threads still see the stack above them
+    XCTAssertTrue([child.layoutStackDescription hasPrefix:@"CKFlexboxComponent"], @"%@", child.layoutStackDescription);
+  }
+}
+
+- (void)testLayingOutAgainInTheSameLayoutPassReusesTheYogaTree
+{
+  CKFlexboxComponent *(^stack)(CKComponent *) = ^(CKComponent *child) {
+    return [CKFlexboxComponent newWithView:{} size:{} style:{.alignItems = CKFlexboxAlignItemsStretch} children:{{child}}];
+  };
+  CKFlexboxParallelTestComponent *child = [CKFlexboxParallelTestComponent newWithView:{} size:{}];
+  CKFlexboxComponent *component = stack(child);
+  CK::Component::LayoutPass pass;
+
+  const CKComponentLayout firstLayout = [component layoutThatFits:{{300, 0}, {300, INFINITY}} parentSize:kCKComponentParentSizeUndefined];
+  const NSUInteger layoutCount = child.layoutCount;
+  const CKComponentLayout secondLayout = [component layoutThatFits:{{300, 0}, {300, INFINITY}} parentSize:kCKComponentParentSizeUndefined];
+  XCTAssertEqual(child.layoutCount, layoutCount, @"Nothing changed, so the child shouldn't be measured again");
+  XCTAssertTrue(CGSizeEqualToSize(firstLayout.size, secondLayout.size));
+
+  // A different size range updates the kept tree, giving the same result as a fresh one
+  const CKComponentLayout narrowLayout = [component layoutThatFits:{{200, 0}, {200, INFINITY}} parentSize:kCKComponentParentSizeUndefined];
+  const CKComponentLayout freshLayout = [stack([CKFlexboxParallelTestComponent newWithView:{} size:{}]) layoutThatFits:{{200, 0}, {200, INFINITY}} parentSize:kCKComponentParentSizeUndefined];
+  XCTAssertTrue(CGSizeEqualToSize(narrowLayout.size, freshLayout.size));
+  XCTAssertTrue(CGSizeEqualToSize(narrowLayout.children->at(0).layout.size, freshLayout.children->at(0).layout.size));
+}
+
+- (void)testTheYogaTreeIsFreedAtTheEndOfTheLayoutPass
+{
+  CKFlexboxParallelTestComponent *child = [CKFlexboxParallelTestComponent newWithView:{} size:{}];
+  CKFlexboxComponent *component =
+  [CKFlexboxComponent newWithView:{} size:{} style:{.alignItems = CKFlexboxAlignItemsStretch} children:{{child}}];
+  {
+    CK::Component::LayoutPass pass;
+    [component layoutThatFits:{{300, 0}, {300, INFINITY}} parentSize:kCKComponentParentSizeUndefined];
+  }
+  const NSUInteger layoutCount = child.layoutCount;
+  {
+    CK::Component::LayoutPass pass;
+    [component layoutThatFits:{{300, 0}, {300, INFINITY}} parentSize:kCKComponentParentSizeUndefined];
+  }
+  XCTAssertGreaterThan(child.layoutCount, layoutCount, @"The next pass should start from a new Yoga tree");
+}
+
 @end
@@ -15,12 +15,16 @@
 #import <ComponentKit/CKComponent.h>
 #import <ComponentKit/CKComponentLayout.h>
 #import <ComponentKit/CKComponentProvider.h>
+#import <ComponentKit/CKComponentScopeRoot.h>
 #import <ComponentKit/CKTransactionalComponentDataSourceAppliedChanges.h>
 #import <ComponentKit/CKTransactionalComponentDataSourceChange.h>
 #import <ComponentKit/CKDataSourceChangeset.h>
 #import <ComponentKit/CKTransactionalComponentDataSourceItem.h>
+#import <ComponentKit/CKTransactionalComponentDataSourceItemInternal.h>
 #import <ComponentKit/CKTransactionalComponentDataSourceChangesetModification.h>
+#import <ComponentKit/CKTransactionalComponentDataSourceConfiguration.h>
 #import <ComponentKit/CKTransactionalComponentDataSourceState.h>
+#import <ComponentKit/CKTransactionalComponentDataSourceStateInternal.h>
 
 #import "CKTransactionalComponentDataSourceStateTestHelpers.h"
 
@@ -81,6 +85,23 @@
   XCTAssertEqual([[change state] numberOfObjectsInSection:0], (NSUInteger)2);
 }
 
+- (void)testBuiltItemsRecordTheirLayoutsForTheFirstStateUpdate
+{
+  CKTransactionalComponentDataSourceState *originalState = CKTransactionalComponentDataSourceTestState([self class], nil, 1, 1);
+  CKDataSourceChangeset *changeset =
+  [[[[CKDataSourceChangesetBuilder transactionalComponentDataSourceChangeset]
+     withUpdatedItems:@{[NSIndexPath indexPathForItem:0 inSection:0]: @1}]
+    withInsertedItems:@{[NSIndexPath indexPathForItem:1 inSection:0]: @2}]
+   build];
+  CKTransactionalComponentDataSourceChangesetModification *changesetModification =
+  [[CKTransactionalComponentDataSourceChangesetModification alloc] initWithChangeset:changeset
+                                                                       stateListener:nil
+                                                                            userInfo:nil];
+  CKTransactionalComponentDataSourceChange *change = [changesetModification changeFromState:originalState];
+  XCTAssertNotNil([[[change state] objectAtIndexPath:[NSIndexPath indexPathForItem:0 inSection:0]] layoutReuseState]);
+  XCTAssertNotNil([[[change state] objectAtIndexPath:[NSIndexPath indexPathForItem:1 inSection:0]] layoutReuseState]);
+}
+
 - (void)testAppliesRemovedItemsThenRemovedSections
 {
   CKTransactionalComponentDataSourceState *originalState = CKTransactionalComponentDataSourceTestState([self class], nil, 2, 2);
@@ -146,6 +167,33 @@
   XCTAssertEqualObjects(c.model, @2);
 }
 
+- (void)testUpdatesAndInsertionsInASectionShiftedByRemovedAndInsertedSections
+{
+  CKTransactionalComponentDataSourceState *originalState = CKTransactionalComponentDataSourceTestState([self class], nil, 3, 2);
+  CKDataSourceChangeset *changeset =
+  [[[[[[CKDataSourceChangesetBuilder transactionalComponentDataSourceChangeset]
+       withUpdatedItems:@{[NSIndexPath indexPathForItem:0 inSection:2]: @"updated"}]
+      withRemovedSections:[NSIndexSet indexSetWithIndex:0]]
+     withInsertedSections:[NSIndexSet indexSetWithIndex:0]]
+    withInsertedItems:@{[NSIndexPath indexPathForItem:2 inSection:2]: @"inserted"}]
+   build];
+  CKTransactionalComponentDataSourceChangesetModification *changesetModification =
+  [[CKTransactionalComponentDataSourceChangesetModification alloc] initWithChangeset:changeset
+                                                                       stateListener:nil
+                                                                            userInfo:nil];
+  CKTransactionalComponentDataSourceState *state = [[changesetModification changeFromState:originalState] state];
+
+  // Old section 2 is copied for the update, and is still section 2 after removing and inserting section 0
+  XCTAssertEqual([state numberOfObjectsInSection:0], (NSUInteger)0);
+  XCTAssertEqual([state numberOfObjectsInSection:1], (NSUInteger)2);
+  XCTAssertEqual([state numberOfObjectsInSection:2], (NSUInteger)3);
+  auto updated = (CKModelExposingComponent *)[[state objectAtIndexPath:[NSIndexPath indexPathForItem:0 inSection:2]] layout].component;
+  XCTAssertEqualObjects(updated.model, @"updated");
+  auto inserted = (CKModelExposingComponent *)[[state objectAtIndexPath:[NSIndexPath indexPathForItem:2 inSection:2]] layout].component;
+  XCTAssertEqualObjects(inserted.model, @"inserted");
+  XCTAssertEqual([state sections][1], [originalState sections][1]);
+}
+
 - (void)testMoveItem
 {
   CKTransactionalComponentDataSourceState *originalState = CKTransactionalComponentDataSourceTestState([self class], nil, 1, 3);
@@ -200,6 +248,63 @@
   XCTAssertEqualObjects(c.model, @0);
 }
 
+- (void)testItemsBuiltInParallelAreInIndexOrder
+{
+  CKTransactionalComponentDataSourceConfiguration *configuration =
+  [[CKTransactionalComponentDataSourceConfiguration alloc] initWithComponentProvider:[self class]
+                                                                             context:nil
+                                                                           sizeRange:{{100, 100}, {100, 100}}
+                                                           alwaysSendComponentUpdate:NO
+                                                                    buildParallelism:4];
+  CKTransactionalComponentDataSourceState *originalState =
+  [[CKTransactionalComponentDataSourceState alloc] initWithConfiguration:configuration sections:@[]];
+  NSMutableDictionary *insertedItems = [NSMutableDictionary dictionary];
+  for (NSUInteger i = 0; i < 50; i++) {
+    insertedItems[[NSIndexPath indexPathForItem:i inSection:0]] = @(i);
+  }
+  CKDataSourceChangeset *changeset =
+  [[[[CKDataSourceChangesetBuilder transactionalComponentDataSourceChangeset]
+     withInsertedSections:[NSIndexSet indexSetWithIndex:0]]
+    withInsertedItems:insertedItems]
+   build];
+  CKTransactionalComponentDataSourceChange *change =
+  [[[CKTransactionalComponentDataSourceChangesetModification alloc] initWithChangeset:changeset
+                                                                       stateListener:nil
+                                                                            userInfo:nil] changeFromState:originalState];
+
+  CKDataSourceChangeset *update =
+  [[[CKDataSourceChangesetBuilder transactionalComponentDataSourceChangeset]
+    withUpdatedItems:@{[NSIndexPath indexPathForItem:3 inSection:0]: @"updated", [NSIndexPath indexPathForItem:7 inSection:0]: @"updated"}]
+   build];
+  change = [[[CKTransactionalComponentDataSourceChangesetModification alloc] initWithChangeset:update
+                                                                                stateListener:nil
+                                                                                     userInfo:nil] changeFromState:[change state]];
+
+  XCTAssertEqual([[change state] numberOfObjectsInSection:0], 50);
+  for (NSUInteger i = 0; i < 50; i++) {
+    auto c = (CKModelExposingComponent *)[[[change state] objectAtIndexPath:[NSIndexPath indexPathForItem:i inSection:0]] layout].component;
+    XCTAssertEqualObjects(c.model, (i == 3 || i == 7) ? @"updated" : @(i));
+  }
+}
+
+- (void)testSectionsWithoutChangesAreSharedWithTheOldState
+{
+  CKTransactionalComponentDataSourceState *originalState = CKTransactionalComponentDataSourceTestState([self class], nil, 3, 2);
+  CKDataSourceChangeset *changeset =
+  [[[[CKDataSourceChangesetBuilder transactionalComponentDataSourceChangeset]
+     withUpdatedItems:@{[NSIndexPath indexPathForItem:0 inSection:1]: @"updated"}]
+    withInsertedItems:@{[NSIndexPath indexPathForItem:2 inSection:2]: @"inserted"}]
+   build];
+  CKTransactionalComponentDataSourceChange *change =
+  [[[CKTransactionalComponentDataSourceChangesetModification alloc] initWithChangeset:changeset
+                                                                       stateListener:nil
+                                                                            userInfo:nil] changeFromState:originalState];
+  XCTAssertEqual([[change state] sections][0], [originalState sections][0]);
+  XCTAssertNotEqual([[change state] sections][1], [originalState sections][1]);
+  XCTAssertNotEqual([[change state] sections][2], [originalState sections][2]);
+  XCTAssertEqual([[originalState sections][2] count], (NSUInteger)2);
+}
+
 - (void)testMoveWithRemovals
 {
   CKTransactionalComponentDataSourceState *originalState = CKTransactionalComponentDataSourceTestState([self class], nil, 1, 4);
@@ -221,4 +326,53 @@
   XCTAssertEqualObjects(c1.model, @0);
 }
 
+- (void)testChangesetDoesNotBuildTheScopeRootIndex
+{
+  CKTransactionalComponentDataSourceState *originalState = CKTransactionalComponentDataSourceTestState([self class], nil, 1, 2);
+  CKDataSourceChangeset *changeset =
+  [[[CKDataSourceChangesetBuilder transactionalComponentDataSourceChangeset]
+    withUpdatedItems:@{[NSIndexPath indexPathForItem:0 inSection:0]: @"updated"}]
+   build];
+  CKTransactionalComponentDataSourceState *state =
+  [[[[CKTransactionalComponentDataSourceChangesetModification alloc] initWithChangeset:changeset
+                                                                        stateListener:nil
+                                                                             userInfo:nil] changeFromState:originalState] state];
+  XCTAssertTrue([originalState builtScopeRootIndex] == nullptr);
+  XCTAssertTrue([state builtScopeRootIndex] == nullptr);
+}
+
+- (void)testScopeRootIndexIsCarriedOverAcrossInsertionsRemovalsAndMoves
+{
+  CKTransactionalComponentDataSourceState *originalState = CKTransactionalComponentDataSourceTestState([self class], nil, 3, 4);
+  const auto originalIndex = [originalState scopeRootIndex];
+  NSIndexPath *removedIndexPath = [NSIndexPath indexPathForItem:1 inSection:2];
+  const CKComponentScopeRootIdentifier removedIdentifier = [[[originalState objectAtIndexPath:removedIndexPath] scopeRoot] globalIdentifier];
+  CKDataSourceChangeset *changeset =
+  [[[[[[[CKDataSourceChangesetBuilder transactionalComponentDataSourceChangeset]
+        withRemovedItems:[NSSet setWithObject:removedIndexPath]]
+       withMovedItems:@{[NSIndexPath indexPathForItem:3 inSection:2]: [NSIndexPath indexPathForItem:0 inSection:0]}]
+      withRemovedSections:[NSIndexSet indexSetWithIndex:1]]
+     withInsertedSections:[NSIndexSet indexSetWithIndex:0]]
+    withInsertedItems:@{[NSIndexPath indexPathForItem:1 inSection:0]: @"inserted",
+                        [NSIndexPath indexPathForItem:4 inSection:1]: @"appended"}]
+   build];
+  CKTransactionalComponentDataSourceState *state =
+  [[[[CKTransactionalComponentDataSourceChangesetModification alloc] initWithChangeset:changeset
+                                                                        stateListener:nil
+                                                                             userInfo:nil] changeFromState:originalState] state];
+
+  const auto index = [state builtScopeRootIndex];
+  XCTAssertTrue(index != nullptr && index != originalIndex);
+  XCTAssertEqual(index->depth(), 2u);
+  [state enumerateObjectsUsingBlock:^(CKTransactionalComponentDataSourceItem *item, NSIndexPath *indexPath, BOOL *stop) {
+    CKTransactionalComponentDataSourceItemPosition position;
+    XCTAssertTrue(index->find([[item scopeRoot] globalIdentifier], position));
+    XCTAssertEqual(position.section, indexPath.section);
+    XCTAssertEqual(position.item, indexPath.item);
+  }];
+  CKTransactionalComponentDataSourceItemPosition position;
+  XCTAssertFalse(index->find(removedIdentifier, position));
+  XCTAssertFalse(index->find([[[originalState objectAtIndexPath:[NSIndexPath indexPathForItem:0 inSection:1]] scopeRoot] globalIdentifier], position));
+}
+
 @end
@@ -50,4 +50,21 @@
   XCTAssertNotEqualObjects(firstConfiguration, secondConfiguration);
 }
 
+- (void)testConfigurationsThatOnlyDifferInBuildParallelismAreEqual
+{
+  CKTransactionalComponentDataSourceConfiguration *firstConfiguration =
+  [[CKTransactionalComponentDataSourceConfiguration alloc] initWithComponentProvider:[CKTransactionalComponentDataSourceConfigurationTests class]
+                                                                             context:@"context"
+                                                                           sizeRange:CKSizeRange()];
+  CKTransactionalComponentDataSourceConfiguration *secondConfiguration =
+  [[CKTransactionalComponentDataSourceConfiguration alloc] initWithComponentProvider:[CKTransactionalComponentDataSourceConfigurationTests class]
+                                                                             context:@"context"
+                                                                           sizeRange:CKSizeRange()
+                                                           alwaysSendComponentUpdate:NO
+                                                                    buildParallelism:4];
+  XCTAssertEqual(firstConfiguration.buildParallelism, (NSUInteger)1);
+  XCTAssertEqualObjects(firstConfiguration, secondConfiguration);
+  XCTAssertEqual([firstConfiguration hash], [secondConfiguration hash]);
+}
+
 @end
@@ -88,6 +88,32 @@
 }
 
 
+- (void)testIteratingOverTheItemsOfASection
+{
+  CKTransactionalComponentDataSourceState *state = CKTransactionalComponentDataSourceTestState([self class], nil, 2, 40);
+  const CKTransactionalComponentDataSourceSectionItems items = [state itemsInSection:1];
+  XCTAssertEqual(items.size(), (NSUInteger)40);
+  NSUInteger count = 0;
+  for (auto it = items.begin(); it != items.end(); ++it) {
+    XCTAssertEqual(it.index(), count);
+    XCTAssertEqualObjects([*it model], @(40 + count));
+    XCTAssertEqual(*it, [state objectAtPosition:{1, (NSInteger)count}]);
+    count++;
+  }
+  XCTAssertEqual(count, (NSUInteger)40);
+}
+
+- (void)testIteratingOverAnEmptySection
+{
+  CKTransactionalComponentDataSourceState *state = CKTransactionalComponentDataSourceTestState([self class], nil, 1, 0);
+  NSUInteger count = 0;
+  for (CKTransactionalComponentDataSourceItem *item : [state itemsInSection:0]) {
+    (void)item;
+    count++;
+  }
+  XCTAssertEqual(count, (NSUInteger)0);
+}
+
 - (void)testStateEquality
 {
   CKTransactionalComponentDataSourceItem *firstItem = [[CKTransactionalComponentDataSourceItem alloc] initWithLayout:CKComponentLayout() model:@"model" scopeRoot:nil boundsAnimation:{}];
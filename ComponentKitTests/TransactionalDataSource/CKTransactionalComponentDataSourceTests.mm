@@ -115,6 +115,38 @@ struct CKDataSourceAnnouncedUpdate {
   }));
 }
 
+- (void)testProgressivelyInsertingItemsAnnouncesEachChunkInOrder
+{
+  CKTransactionalComponentDataSource *ds =
+  [[CKTransactionalComponentDataSource alloc] initWithConfiguration:
+   [[CKTransactionalComponentDataSourceConfiguration alloc] initWithComponentProvider:[self class]
+                                                                              context:nil
+                                                                            sizeRange:{}]];
+  [ds addListener:self];
+
+  NSMutableDictionary *insertedItems = [NSMutableDictionary dictionary];
+  for (NSUInteger i = 0; i < 5; i++) {
+    insertedItems[[NSIndexPath indexPathForItem:i inSection:0]] = @(i);
+  }
+  CKDataSourceChangeset *insertion =
+  [[[[CKDataSourceChangesetBuilder transactionalComponentDataSourceChangeset]
+     withInsertedSections:[NSIndexSet indexSetWithIndex:0]]
+    withInsertedItems:insertedItems]
+   build];
+  [ds applyChangesetProgressively:insertion chunkSize:2 userInfo:nil];
+
+  XCTAssertTrue(CKRunRunLoopUntilBlockIsTrue(^BOOL(void){
+    return _announcedChanges.size() == 3;
+  }));
+  XCTAssertEqualObjects([_announcedChanges[0].appliedChanges insertedSections], [NSIndexSet indexSetWithIndex:0]);
+  XCTAssertEqualObjects([_announcedChanges[0].appliedChanges insertedIndexPaths], (CKTestIndexPaths(1, 2)));
+  XCTAssertEqual([_announcedChanges[1].previousState numberOfObjectsInSection:0], 2);
+  XCTAssertEqual([[_announcedChanges[1].appliedChanges insertedIndexPaths] count], (NSUInteger)2);
+  XCTAssertEqualObjects([_announcedChanges[2].appliedChanges insertedIndexPaths],
+                        [NSSet setWithObject:[NSIndexPath indexPathForItem:4 inSection:0]]);
+  XCTAssertEqual([[ds state] numberOfObjectsInSection:0], 5);
+}
+
 - (void)testUpdatingConfigurationAnnouncesUpdate
 {
   CKTransactionalComponentDataSource *ds = CKTransactionalComponentTestDataSource([self class]);
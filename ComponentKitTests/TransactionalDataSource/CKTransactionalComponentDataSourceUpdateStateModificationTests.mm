@@ -20,6 +20,7 @@
 #import <ComponentKit/CKTransactionalComponentDataSourceItem.h>
 #import <ComponentKit/CKTransactionalComponentDataSourceState.h>
 
+#import "CKTransactionalComponentDataSourceStateInternal.h"
 #import "CKTransactionalComponentDataSourceStateTestHelpers.h"
 #import "CKTransactionalComponentDataSourceUpdateStateModification.h"
 
@@ -135,4 +136,28 @@
   XCTAssertEqualObjects(updatedComponentState, @"hello world");
 }
 
+- (void)testUpdatesItemFoundThroughScopeRootIndexAndSharesIndexWithNewState
+{
+  CKTransactionalComponentDataSourceState *originalState = CKTransactionalComponentDataSourceTestState([self class], self, 3, 4);
+
+  NSIndexPath *ip = [NSIndexPath indexPathForItem:3 inSection:2];
+  CKTransactionalComponentDataSourceItem *item = [originalState objectAtIndexPath:ip];
+  const auto index = [originalState scopeRootIndex];
+  CKTransactionalComponentDataSourceItemPosition position;
+  XCTAssertTrue(index->find([[item scopeRoot] globalIdentifier], position));
+  XCTAssertEqual(position.section, 2);
+  XCTAssertEqual(position.item, 3);
+
+  [[item layout].component updateState:^(id state){return @"hello";} mode:CKUpdateModeSynchronous];
+  CKTransactionalComponentDataSourceUpdateStateModification *updateStateModification =
+  [[CKTransactionalComponentDataSourceUpdateStateModification alloc] initWithStateUpdates:_pendingStateUpdates];
+  CKTransactionalComponentDataSourceChange *change = [updateStateModification changeFromState:originalState];
+
+  NSString *updatedComponentState =
+  [(CKStatefulTestComponent *)[[[change state] objectAtIndexPath:ip] layout].component state];
+  XCTAssertEqualObjects(updatedComponentState, @"hello");
+  XCTAssertEqualObjects([[change appliedChanges] updatedIndexPaths], [NSSet setWithObject:ip]);
+  XCTAssertTrue([[change state] scopeRootIndex] == index);
+}
+
 @end
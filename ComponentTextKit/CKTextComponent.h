@@ -8,6 +8,8 @@
  *
  */
 
+#import <vector>
+
 #import <ComponentKit/CKComponent.h>
 
 #import <ComponentKit/CKAsyncLayer.h>
@@ -40,4 +42,29 @@ struct CKTextComponentOptions
                               options:(const CKTextComponentOptions &)options
                                  size:(const CKComponentSize &)size;
 
+/**
+ Lays out and rasterizes text in the prefetch lane of the async display scheduler ahead of mount, e.g. for the items
+ just beyond the visible range of a CKCollectionViewTransactionalDataSource. Sizes are the component sizes the text will
+ be mounted at (the size of its CKComponentLayout). When a text component with equal attributes is later displayed at that size, its
+ layer takes the bitmap from the raster cache instead of drawing during the scroll.
+
+ The text is drawn on the default opaque white background of CKTextComponentView. Text components with another
+ background must be prerendered with +prerenderTextWithAttributes:sizes:backgroundColor:opaque:, or their layers
+ won't use the bitmaps.
+
+ @param attributes The text attributes, one per item.
+ @param sizes The mounted size of each item; must have as many elements as attributes.
+ */
++ (void)prerenderTextWithAttributes:(const std::vector<CKTextKitAttributes> &)attributes
+                              sizes:(const std::vector<CGSize> &)sizes;
+
+/**
+ Same as +prerenderTextWithAttributes:sizes:, drawing the text on the background and with the opacity its
+ CKTextComponentView's layer will have.
+ */
++ (void)prerenderTextWithAttributes:(const std::vector<CKTextKitAttributes> &)attributes
+                              sizes:(const std::vector<CGSize> &)sizes
+                    backgroundColor:(UIColor *)backgroundColor
+                             opaque:(BOOL)opaque;
+
 @end
@@ -9,23 +9,37 @@
  */
 
 #import "CKTextComponent.h"
+#import "CKTextComponentInternal.h"
 
 #import <memory>
 #import <vector>
 
 #import <ComponentKit/CKComponentInternal.h>
+#import <ComponentKit/CKComponentLayoutBaseline.h>
 
 #import <ComponentKit/CKTextKitRenderer.h>
 #import <ComponentKit/CKTextKitRendererCache.h>
+#import <ComponentKit/CKTextKitShapedTextCache.h>
 
 #import <ComponentKit/CKInternalHelpers.h>
 
+#import "CKAsyncDisplayScheduler.h"
+#import "CKTextComponentLayer.h"
 #import "CKTextComponentView.h"
 
-static CK::TextKit::Renderer::Cache *sharedRendererCache()
+static CK::TextKit::Renderer::ShardedCache *sharedRendererCache()
 {
-  // This cache is sized arbitrarily
-  static CK::TextKit::Renderer::Cache *__rendererCache (new CK::TextKit::Renderer::Cache("CKTextComponentRendererCache", 500, 0.2));
+  // Budgeted in bytes using -[CKTextKitRenderer estimatedCost]; 4MB holds roughly 500 short labels, but far fewer long
+  // posts. It is sharded because layout runs on several background threads at once; only every fourth hit updates the
+  // LRU order so that concurrent lookups in the same shard share the lock.
+  // The budget is split evenly between the 8 shards, so each shard evicts on its own once it holds 512KB. At roughly
+  // 20 bytes per character that is about 25,000 characters of text. A renderer for a post of a few thousand
+  // characters takes a tenth of its shard, and one for text longer than a shard holds isn't kept at all.
+  static CK::TextKit::Renderer::ShardedCache *__rendererCache = ^{
+    auto *cache = new CK::TextKit::Renderer::ShardedCache("CKTextComponentRendererCache", 4 * 1024 * 1024, 0.2);
+    cache->implementation().setTouchSampleRate(4);
+    return cache;
+  }();
   return __rendererCache;
 }
 
@@ -36,7 +50,7 @@ static CK::TextKit::Renderer::Cache *sharedRendererCache()
  */
 static CKTextKitRenderer *rendererForAttributes(CKTextKitAttributes &attributes, CGSize constrainedSize)
 {
-  CK::TextKit::Renderer::Cache *cache = sharedRendererCache();
+  CK::TextKit::Renderer::ShardedCache *cache = sharedRendererCache();
   const CK::TextKit::Renderer::Key key {
     attributes,
     constrainedSize
@@ -49,12 +63,31 @@ static CKTextKitRenderer *rendererForAttributes(CKTextKitAttributes &attributes,
     [[CKTextKitRenderer alloc]
      initWithTextKitAttributes:attributes
      constrainedSize:constrainedSize];
-    cache->cacheObject(key, renderer, 1);
+    cache->cacheObject(key, renderer, renderer.estimatedCost);
   }
 
   return renderer;
 }
 
+/**
+ Measurement doesn't need a renderer of its own: unless one is already cached for this exact size, measure against the
+ width-independent shaped text so that measuring at several widths doesn't rebuild TextKit each time. The renderer for
+ the final size is only built at mount.
+ */
+static CGSize sizeForAttributes(CKTextKitAttributes &attributes, CGSize constrainedSize, CGFloat *baseline)
+{
+  CKTextKitRenderer *renderer = sharedRendererCache()->objectForKey({attributes, constrainedSize});
+  if (!renderer) {
+    CGSize size;
+    if (CK::TextKit::ShapedText::measure(attributes, constrainedSize, &size, baseline)) {
+      return size;
+    }
+    renderer = rendererForAttributes(attributes, constrainedSize);
+  }
+  *baseline = renderer.baseline;
+  return renderer.size;
+}
+
 @implementation CKTextComponent
 {
   CKTextKitAttributes _attributes;
@@ -85,16 +118,51 @@ static CKTextKitRenderer *rendererForAttributes(CKTextKitAttributes &attributes,
   return c;
 }
 
++ (CK::CacheStats)rendererCacheStats
+{
+  return sharedRendererCache()->stats();
+}
+
++ (void)prerenderTextWithAttributes:(const std::vector<CKTextKitAttributes> &)attributes
+                              sizes:(const std::vector<CGSize> &)sizes
+{
+  [self prerenderTextWithAttributes:attributes sizes:sizes backgroundColor:[UIColor whiteColor] opaque:YES];
+}
+
++ (void)prerenderTextWithAttributes:(const std::vector<CKTextKitAttributes> &)attributes
+                              sizes:(const std::vector<CGSize> &)sizes
+                    backgroundColor:(UIColor *)backgroundColor
+                             opaque:(BOOL)opaque
+{
+  CKAssert(attributes.size() == sizes.size(), @"Expected one size per attributes, got %zu attributes and %zu sizes",
+           attributes.size(), sizes.size());
+  CKAsyncDisplayScheduler *scheduler = [CKAsyncDisplayScheduler sharedScheduler];
+  for (size_t i = 0; i < MIN(attributes.size(), sizes.size()); i++) {
+    const CKTextKitAttributes copiedAttributes = attributes[i].copy();
+    const CGSize size = sizes[i];
+    // Prerendering is speculative, so it only runs when there is no display work for content closer to the screen.
+    [scheduler scheduleBlock:^{
+      CKTextKitAttributes blockAttributes = copiedAttributes;
+      [CKTextComponentLayer prerenderRenderer:rendererForAttributes(blockAttributes, size)
+                              backgroundColor:backgroundColor.CGColor
+                                       opaque:opaque];
+    } cancellation:nil priority:CKAsyncDisplayPriorityPrefetch displaySentinel:NULL expectedDisplaySentinelValue:0];
+  }
+}
+
 - (CKComponentLayout)computeLayoutThatFits:(CKSizeRange)constrainedSize
 {
-  const CKTextKitRenderer *renderer = rendererForAttributes(_attributes, constrainedSize.max);
+  CGFloat baseline;
+  const CGSize size = sizeForAttributes(_attributes, constrainedSize.max, &baseline);
   return {
     self,
     constrainedSize.clamp({
-      CKCeilPixelValue(renderer.size.width),
-      CKCeilPixelValue(renderer.size.height)
+      CKCeilPixelValue(size.width),
+      CKCeilPixelValue(size.height)
     }),
-    {}
+    {},
+    // Lets stacks align text on its baseline without measuring it again.
+    @{kCKComponentLayoutExtraBaselineKey: @(baseline)}
   };
 }
 
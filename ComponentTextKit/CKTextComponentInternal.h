@@ -0,0 +1,22 @@
+/*
+ *  Copyright (c) 2014-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+
+#import <ComponentKit/CKCacheImpl.h>
+#import <ComponentKit/CKTextComponent.h>
+
+@interface CKTextComponent ()
+
+/**
+ Counters for the process-wide cache of text renderers shared by all text components. Costs are estimated bytes.
+ Useful for sizing the cache from production data.
+ */
++ (CK::CacheStats)rendererCacheStats;
+
+@end
@@ -9,6 +9,7 @@
  */
 
 #import <ComponentKit/CKAsyncLayer.h>
+#import <ComponentKit/CKCacheImpl.h>
 
 @class CKTextComponentLayerHighlighter;
 @class CKTextKitRenderer;
@@ -22,4 +23,16 @@
 
 @property (nonatomic, strong, readonly) CKTextComponentLayerHighlighter *highlighter;
 
+/** Counters for the shared raster contents cache. Costs are in bytes. */
++ (CK::CacheStats)rasterContentsCacheStats;
+
+/**
+ Synchronously rasterizes the renderer's text on the given background at the screen scale into the shared raster
+ contents cache, unless the cache already holds it. A layer later displaying an equal renderer picks the bitmap up in
+ -willDisplayAsynchronouslyWithDrawParameters: instead of drawing, provided its background, opacity and scale match.
+
+ Meant to be called on a background queue; see +[CKTextComponent prerenderTextWithAttributes:sizes:backgroundColor:opaque:].
+ */
++ (void)prerenderRenderer:(CKTextKitRenderer *)renderer backgroundColor:(CGColorRef)backgroundColor opaque:(BOOL)opaque;
+
 @end
@@ -16,6 +16,7 @@
 #import <ComponentKit/CKTextKitRendererCache.h>
 #import <ComponentKit/CKAssert.h>
 
+#import "CKAsyncLayerInternal.h"
 #import "CKTextComponentLayerHighlighter.h"
 
 static CK::TextKit::Renderer::Cache *rasterContentsCache()
@@ -25,11 +26,80 @@ static CK::TextKit::Renderer::Cache *rasterContentsCache()
   return __rasterContentsCache;
 }
 
+static void cacheRasterContents(CKTextKitRenderer *renderer, id contents, CGRect region = CGRectNull)
+{
+  CGImageRef imageRef = (__bridge CGImageRef)contents;
+  NSUInteger bytes = CGImageGetBytesPerRow(imageRef) * CGImageGetHeight(imageRef);
+  rasterContentsCache()->cacheObject({renderer.attributes, renderer.constrainedSize, region}, contents, bytes);
+}
+
+/**
+ A bitmap drawn by +prerenderRenderer:backgroundColor:opaque:. The raster cache key doesn't carry the background the
+ text was drawn on, so prerendered bitmaps remember it and are only handed to layers that would have drawn the same.
+ */
+@interface CKTextComponentPrerenderedContents : NSObject
+{
+@package
+  id _contents;
+  id _backgroundColor;
+  BOOL _opaque;
+  CGFloat _contentsScale;
+}
+@end
+
+@implementation CKTextComponentPrerenderedContents
+@end
+
+static BOOL layerMatchesPrerenderedContents(CALayer *layer, CKTextComponentPrerenderedContents *prerendered)
+{
+  return layer.opaque == prerendered->_opaque
+  && layer.contentsScale == prerendered->_contentsScale
+  && CGColorEqualToColor(layer.backgroundColor, (__bridge CGColorRef)prerendered->_backgroundColor);
+}
+
 @implementation CKTextComponentLayer
 {
   CKTextComponentLayerHighlighter *_highlighter;
 }
 
++ (CK::CacheStats)rasterContentsCacheStats
+{
+  return rasterContentsCache()->stats();
+}
+
++ (void)prerenderRenderer:(CKTextKitRenderer *)renderer backgroundColor:(CGColorRef)backgroundColor opaque:(BOOL)opaque
+{
+  const CGSize size = renderer.constrainedSize;
+  if (!renderer || size.width <= 0 || size.height <= 0 || isinf(size.width) || isinf(size.height)) {
+    return;
+  }
+  if (rasterContentsCache()->objectForKey({renderer.attributes, size})) {
+    return;
+  }
+  const CGFloat contentsScale = CKScreenScale();
+  // Same drawing routine as an async -display, minus the sentinel since there's no layer to cancel it.
+  ck_async_transaction_operation_block_t displayBlock =
+  [self asyncDisplayBlockWithBounds:{.size = size}
+                      contentsScale:contentsScale
+                             opaque:opaque
+                    backgroundColor:backgroundColor
+                    displaySentinel:nil
+       expectedDisplaySentinelValue:0
+                    drawingDelegate:(id<CKAsyncLayerDrawingDelegate>)self
+                     drawParameters:renderer];
+  id contents = displayBlock();
+  if (contents) {
+    CKTextComponentPrerenderedContents *prerendered = [[CKTextComponentPrerenderedContents alloc] init];
+    prerendered->_contents = contents;
+    prerendered->_backgroundColor = (__bridge id)backgroundColor;
+    prerendered->_opaque = opaque;
+    prerendered->_contentsScale = contentsScale;
+    CGImageRef imageRef = (__bridge CGImageRef)contents;
+    rasterContentsCache()->cacheObject({renderer.attributes, size}, prerendered,
+                                       CGImageGetBytesPerRow(imageRef) * CGImageGetHeight(imageRef));
+  }
+}
+
 + (id)defaultValueForKey:(NSString *)key
 {
   if ([key isEqualToString:@"contentsScale"]) {
@@ -85,21 +155,37 @@ static CK::TextKit::Renderer::Cache *rasterContentsCache()
 
 - (id)willDisplayAsynchronouslyWithDrawParameters:(id<NSObject>)drawParameters
 {
-  return rasterContentsCache()->objectForKey({_renderer.attributes, _renderer.constrainedSize});
+  id contents = rasterContentsCache()->objectForKey({_renderer.attributes, _renderer.constrainedSize});
+  if ([contents isKindOfClass:[CKTextComponentPrerenderedContents class]]) {
+    CKTextComponentPrerenderedContents *prerendered = contents;
+    // Draw rather than show text on another background; the bitmap we draw then replaces the prerendered one.
+    return layerMatchesPrerenderedContents(self, prerendered) ? prerendered->_contents : nil;
+  }
+  return contents;
 }
 
 - (void)didDisplayAsynchronously:(id)newContents withDrawParameters:(id<NSObject>)drawParameters
 {
   if (newContents) {
-    CGImageRef imageRef = (__bridge CGImageRef)newContents;
-    NSUInteger bytes = CGImageGetBytesPerRow(imageRef) * CGImageGetHeight(imageRef);
-    rasterContentsCache()->cacheObject({_renderer.attributes, _renderer.constrainedSize}, newContents, bytes);
+    cacheRasterContents(_renderer, newContents);
   }
 }
 
+- (id)willDisplayTileAsynchronouslyInRect:(CGRect)tileRect withDrawParameters:(id<NSObject>)drawParameters
+{
+  return rasterContentsCache()->objectForKey({_renderer.attributes, _renderer.constrainedSize, tileRect});
+}
+
+- (void)didDisplayTileAsynchronously:(id)newContents inRect:(CGRect)tileRect withDrawParameters:(id<NSObject>)drawParameters
+{
+  cacheRasterContents(_renderer, newContents, tileRect);
+}
+
 + (void)drawInContext:(CGContextRef)context parameters:(CKTextKitRenderer *)renderer
 {
-  CGRect boundsRect = CGContextGetClipBoundingBox(context);
+  // The renderer lays its text out relative to the origin of these bounds, so they must span the whole text even when
+  // the context only covers one tile of it; the renderer clips to the context itself.
+  CGRect boundsRect = {CGPointZero, renderer.constrainedSize};
   [renderer drawInContext:context bounds:boundsRect];
 }
 
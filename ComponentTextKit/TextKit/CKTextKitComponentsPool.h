@@ -0,0 +1,64 @@
+/*
+ *  Copyright (c) 2014-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+
+#import <UIKit/UIKit.h>
+
+#import <mutex>
+#import <vector>
+
+/** A text storage, layout manager and text container that are already wired to each other. */
+struct CKTextKitComponents {
+  NSTextStorage *textStorage;
+  NSLayoutManager *layoutManager;
+  NSTextContainer *textContainer;
+};
+
+/**
+ Creates a TextKit stack with our default configuration, under the global lock that every TextKit construction must be
+ made under.
+ */
+CKTextKitComponents CKCreateTextKitComponents(NSAttributedString *attributedString,
+                                              NSLayoutManager*(*layoutManagerFactory)(void));
+
+/**
+ Pre-built default TextKit stacks. Contexts take one from here instead of constructing TextKit under the global lock,
+ and give it back when they are deallocated. When the pool runs low it is refilled on a background queue, so the
+ construction lock is only ever taken off the layout threads (or when the pool is exhausted).
+ */
+class CKTextKitComponentsPool {
+public:
+  /** A dequeue that leaves fewer stacks than this in the pool starts a refill. */
+  static const size_t kRefillThreshold = 4;
+  /** A refill builds stacks until the pool holds this many. */
+  static const size_t kRefillTarget = 8;
+  /** Stacks given back to a pool that holds this many are dropped. */
+  static const size_t kMaximumSize = 16;
+
+  static CKTextKitComponentsPool &sharedPool();
+
+  /** Takes a stack out of the pool. Returns false if the pool is empty; the caller must then build one itself. */
+  bool dequeue(CKTextKitComponents &components);
+
+  /**
+   Gives a stack back to the pool. Its text storage is emptied and its text container reset to the way
+   CKCreateTextKitComponents builds it, so the next user gets a blank stack.
+   */
+  void enqueue(const CKTextKitComponents &components);
+
+  /** The number of stacks in the pool. */
+  size_t size();
+
+private:
+  void _scheduleRefillIfNeeded();
+
+  std::mutex _lock;
+  std::vector<CKTextKitComponents> _components;
+  bool _refillScheduled = false;
+};
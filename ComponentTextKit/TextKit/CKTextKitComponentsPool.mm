@@ -0,0 +1,92 @@
+/*
+ *  Copyright (c) 2014-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+
+#import "CKTextKitComponentsPool.h"
+
+// Concurrently initialising TextKit components crashes (rdar://18448377) so every construction happens under this lock.
+static std::mutex __textKitConstructionMutex;
+
+CKTextKitComponents CKCreateTextKitComponents(NSAttributedString *attributedString,
+                                              NSLayoutManager*(*layoutManagerFactory)(void))
+{
+  std::lock_guard<std::mutex> l(__textKitConstructionMutex);
+  // Create the TextKit component stack with our default configuration.
+  NSTextStorage *textStorage = (attributedString ? [[NSTextStorage alloc] initWithAttributedString:attributedString] : [[NSTextStorage alloc] init]);
+  NSLayoutManager *layoutManager = layoutManagerFactory ? layoutManagerFactory() : [[NSLayoutManager alloc] init];
+  layoutManager.usesFontLeading = NO;
+  [textStorage addLayoutManager:layoutManager];
+  NSTextContainer *textContainer = [[NSTextContainer alloc] initWithSize:CGSizeZero];
+  // We want the text laid out up to the very edges of the container.
+  textContainer.lineFragmentPadding = 0;
+  [layoutManager addTextContainer:textContainer];
+  return {textStorage, layoutManager, textContainer};
+}
+
+CKTextKitComponentsPool &CKTextKitComponentsPool::sharedPool()
+{
+  static CKTextKitComponentsPool *pool = new CKTextKitComponentsPool();
+  return *pool;
+}
+
+void CKTextKitComponentsPool::_scheduleRefillIfNeeded()
+{
+  // Called with _lock held.
+  if (_refillScheduled || _components.size() >= kRefillThreshold) {
+    return;
+  }
+  _refillScheduled = true;
+  dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_BACKGROUND, 0), ^{
+    for (;;) {
+      {
+        std::lock_guard<std::mutex> l(_lock);
+        if (_components.size() >= kRefillTarget) {
+          _refillScheduled = false;
+          return;
+        }
+      }
+      CKTextKitComponents components = CKCreateTextKitComponents(nil, nil);
+      std::lock_guard<std::mutex> l(_lock);
+      _components.push_back(components);
+    }
+  });
+}
+
+bool CKTextKitComponentsPool::dequeue(CKTextKitComponents &components)
+{
+  std::lock_guard<std::mutex> l(_lock);
+  const bool dequeued = !_components.empty();
+  if (dequeued) {
+    components = _components.back();
+    _components.pop_back();
+  }
+  _scheduleRefillIfNeeded();
+  return dequeued;
+}
+
+void CKTextKitComponentsPool::enqueue(const CKTextKitComponents &components)
+{
+  // Drop the text right away so the pool doesn't keep large strings and their glyphs alive.
+  [components.textStorage setAttributedString:[[NSAttributedString alloc] init]];
+  NSTextContainer *textContainer = components.textContainer;
+  textContainer.size = CGSizeZero;
+  textContainer.exclusionPaths = @[];
+  textContainer.lineBreakMode = NSLineBreakByWordWrapping;
+  textContainer.maximumNumberOfLines = 0;
+  std::lock_guard<std::mutex> l(_lock);
+  if (_components.size() < kMaximumSize) {
+    _components.push_back(components);
+  }
+}
+
+size_t CKTextKitComponentsPool::size()
+{
+  std::lock_guard<std::mutex> l(_lock);
+  return _components.size();
+}
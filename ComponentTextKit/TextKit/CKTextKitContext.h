@@ -21,7 +21,9 @@
 /**
  Initializes a context and its associated TextKit components.
 
- Initialization of TextKit components is a globally locking operation so be careful of bottlenecks with this class.
+ Initialization of TextKit components is a globally locking operation. Contexts without a custom layoutManagerFactory
+ avoid it by taking a pre-built TextKit stack from a pool that is refilled in the background, and hand the stack back
+ to the pool when deallocated.
  */
 - (instancetype)initWithAttributedString:(NSAttributedString *)attributedString
                            lineBreakMode:(NSLineBreakMode)lineBreakMode
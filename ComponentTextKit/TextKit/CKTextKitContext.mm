@@ -12,6 +12,8 @@
 
 #import <ComponentKit/CKTextKitContext.h>
 
+#import "CKTextKitComponentsPool.h"
+
 @implementation CKTextKitContext
 {
   // All TextKit operations (even non-mutative ones) must be executed serially.
@@ -20,6 +22,9 @@
   NSLayoutManager *_layoutManager;
   NSTextStorage *_textStorage;
   NSTextContainer *_textContainer;
+
+  // Whether the TextKit stack came from CKTextKitComponentsPool and should be returned to it.
+  BOOL _pooled;
 }
 
 - (instancetype)initWithAttributedString:(NSAttributedString *)attributedString
@@ -29,24 +34,33 @@
                     layoutManagerFactory:(NSLayoutManager*(*)(void))layoutManagerFactory
 {
   if (self = [super init]) {
-    // Concurrently initialising TextKit components crashes (rdar://18448377) so we use a global lock.
-    static std::mutex __static_mutex;
-    std::lock_guard<std::mutex> l(__static_mutex);
-    // Create the TextKit component stack with our default configuration.
-    _textStorage = (attributedString ? [[NSTextStorage alloc] initWithAttributedString:attributedString] : [[NSTextStorage alloc] init]);
-    _layoutManager = layoutManagerFactory ? layoutManagerFactory() : [[NSLayoutManager alloc] init];
-    _layoutManager.usesFontLeading = NO;
-    [_textStorage addLayoutManager:_layoutManager];
-    _textContainer = [[NSTextContainer alloc] initWithSize:constrainedSize];
-    // We want the text laid out up to the very edges of the container.
-    _textContainer.lineFragmentPadding = 0;
+    CKTextKitComponents components;
+    // Custom layout managers can't be pooled, they are always built on demand.
+    if (!layoutManagerFactory && CKTextKitComponentsPool::sharedPool().dequeue(components)) {
+      _pooled = YES;
+      if (attributedString) {
+        [components.textStorage setAttributedString:attributedString];
+      }
+    } else {
+      components = CKCreateTextKitComponents(attributedString, layoutManagerFactory);
+    }
+    _textStorage = components.textStorage;
+    _layoutManager = components.layoutManager;
+    _textContainer = components.textContainer;
+    _textContainer.size = constrainedSize;
     _textContainer.lineBreakMode = lineBreakMode;
     _textContainer.maximumNumberOfLines = maximumNumberOfLines;
-    [_layoutManager addTextContainer:_textContainer];
   }
   return self;
 }
 
+- (void)dealloc
+{
+  if (_pooled) {
+    CKTextKitComponentsPool::sharedPool().enqueue({_textStorage, _layoutManager, _textContainer});
+  }
+}
+
 - (void)performBlockWithLockedTextKitComponents:(void (^)(NSLayoutManager *,
                                                           NSTextStorage *,
                                                           NSTextContainer *))block
@@ -0,0 +1,21 @@
+/*
+ *  Copyright (c) 2014-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+
+#import <Foundation/Foundation.h>
+
+/**
+ Rough per-item footprints, in bytes, that the text caches budget their entries with. They don't need to be exact, only
+ proportional to what TextKit really allocates so that long strings weigh correspondingly more than short labels. Both
+ the renderer cache and the shaped text cache use them, so that their budgets are in the same units.
+ */
+static const NSUInteger kCKTextKitBaseCost = 4096;  // The renderer, context, truncater, shadower and empty TextKit stack.
+static const NSUInteger kCKTextKitCostPerCharacter = 2 * sizeof(unichar);  // Backing string plus attribute runs.
+static const NSUInteger kCKTextKitCostPerGlyph = 16;  // Glyph, glyph properties, character index and location.
+static const NSUInteger kCKTextKitCostPerLineFragment = 96;  // Line fragment rect, used rect and glyph range.
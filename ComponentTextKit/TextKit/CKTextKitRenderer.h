@@ -54,7 +54,7 @@
 
 #pragma mark - Drawing
 /*
- Draw the renderer's text content into the bounds provided.
+ Draw the renderer's text content into the bounds provided. Only the lines intersecting the context's clip are drawn.
 
  @param bounds The rect in which to draw the contents of the renderer.
  */
@@ -67,6 +67,19 @@
  */
 - (CGSize)size;
 
+/*
+ An estimate, in bytes, of the memory held by the renderer's TextKit stack. Derived from the text storage length and
+ the number of glyphs and line fragments laid out, so that caches can budget renderers by real memory footprint
+ instead of by count.
+ */
+- (NSUInteger)estimatedCost;
+
+/*
+ The distance from the top of the renderer's bounds to the baseline of the first line of text, or 0 if there is no
+ text. Computed along with the size, so it is safe to call from layout code without taking the TextKit lock.
+ */
+- (CGFloat)baseline;
+
 #pragma mark - Text Ranges
 
 /*
@@ -76,8 +89,14 @@
 - (std::vector<NSRange>)visibleRanges;
 
 /*
- The number of lines shown in the string.
+ The number of lines shown in the string. Computed along with the size.
  */
 - (NSUInteger)lineCount;
 
+/*
+ Whether any of the original attributedString is not displayed, either because a truncation string replaced it or
+ because it did not fit within the constrained size or maximum number of lines.
+ */
+- (BOOL)isTruncated;
+
 @end
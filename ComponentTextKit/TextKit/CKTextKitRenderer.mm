@@ -13,6 +13,7 @@
 #import <ComponentKit/CKAssert.h>
 
 #import <ComponentKit/CKTextKitContext.h>
+#import <ComponentKit/CKTextKitCostEstimates.h>
 #import <ComponentKit/CKTextKitShadower.h>
 #import <ComponentKit/CKTextKitTailTruncater.h>
 #import <ComponentKit/CKTextKitTruncating.h>
@@ -32,6 +33,10 @@ static NSCharacterSet *_defaultAvoidTruncationCharacterSet()
 
 @implementation CKTextKitRenderer {
   CGSize _calculatedSize;
+  NSUInteger _estimatedCost;
+  NSUInteger _lineCount;
+  CGFloat _baseline;
+  BOOL _truncated;
 }
 
 #pragma mark - Initialization
@@ -62,31 +67,65 @@ static NSCharacterSet *_defaultAvoidTruncationCharacterSet()
                                           avoidTailTruncationSet:attributes.avoidTailTruncationSet ?: _defaultAvoidTruncationCharacterSet()
                                                  constrainedSize:shadowConstrainedSize];
 
-    [self _calculateSize];
+    [self _measure];
   }
   return self;
 }
 
 #pragma mark - Sizing
 
-- (void)_calculateSize
+/**
+ Gathers everything layout needs to know about the text in a single pass under the TextKit lock, so that size, line
+ count, baseline and truncation state can be read afterwards without going back into TextKit.
+ */
+- (void)_measure
 {
-  // Force glyph generation and layout, which may not have happened yet (and isn't triggered by
-  // -usedRectForTextContainer:).
+  __block NSUInteger estimatedCost = kCKTextKitBaseCost;
+  __block NSUInteger lineCount = 0;
+  __block CGFloat internalBaseline = 0;
+  __block CGRect boundingRect;
   [_context performBlockWithLockedTextKitComponents:^(NSLayoutManager *layoutManager, NSTextStorage *textStorage, NSTextContainer *textContainer) {
+    // Force glyph generation and layout, which may not have happened yet (and isn't triggered by
+    // -usedRectForTextContainer:).
     [layoutManager ensureLayoutForTextContainer:textContainer];
-  }];
 
+    const NSUInteger numberOfGlyphs = [layoutManager numberOfGlyphs];
+    __block NSUInteger numberOfLineFragments = 0;
+    // Like it always has, the line count stops at the first empty line fragment
+    __block BOOL countsLines = YES;
+    [layoutManager enumerateLineFragmentsForGlyphRange:NSMakeRange(0, numberOfGlyphs)
+                                            usingBlock:^(CGRect rect, CGRect usedRect, NSTextContainer *container, NSRange glyphRange, BOOL *stop) {
+                                              if (numberOfLineFragments == 0) {
+                                                // Glyph locations are relative to the origin of their line fragment.
+                                                internalBaseline = CGRectGetMinY(rect) + [layoutManager locationForGlyphAtIndex:glyphRange.location].y;
+                                              }
+                                              numberOfLineFragments++;
+                                              if (CGRectIsEmpty(rect)) {
+                                                countsLines = NO;
+                                              } else if (countsLines) {
+                                                lineCount++;
+                                              }
+                                            }];
+    estimatedCost += textStorage.length * kCKTextKitCostPerCharacter
+    + numberOfGlyphs * kCKTextKitCostPerGlyph
+    + numberOfLineFragments * kCKTextKitCostPerLineFragment;
 
-  CGRect constrainedRect = {CGPointZero, _constrainedSize};
-  __block CGRect boundingRect;
-  [_context performBlockWithLockedTextKitComponents:^(NSLayoutManager *layoutManager, NSTextStorage *textStorage, NSTextContainer *textContainer) {
     boundingRect = [layoutManager usedRectForTextContainer:textContainer];
   }];
+  _estimatedCost = estimatedCost;
+  _lineCount = lineCount;
+  _baseline = lineCount > 0 ? [_shadower offsetPointWithInternalPoint:{0, internalBaseline}].y : 0;
+
+  // The truncater has already run, so its visible ranges tell whether any of the original string was cut off.
+  NSUInteger visibleLength = 0;
+  for (const NSRange &range : _truncater.visibleRanges) {
+    visibleLength += range.length;
+  }
+  _truncated = visibleLength < _attributes.attributedString.length;
 
   // TextKit often returns incorrect glyph bounding rects in the horizontal direction, so we clip to our bounding rect
   // to make sure our width calculations aren't being offset by glyphs going beyond the constrained rect.
-  boundingRect = CGRectIntersection(boundingRect, {.size = constrainedRect.size});
+  boundingRect = CGRectIntersection(boundingRect, {.size = _constrainedSize});
 
   _calculatedSize = [_shadower outsetSizeWithInsetSize:boundingRect.size];
 }
@@ -96,6 +135,16 @@ static NSCharacterSet *_defaultAvoidTruncationCharacterSet()
   return _calculatedSize;
 }
 
+- (NSUInteger)estimatedCost
+{
+  return _estimatedCost;
+}
+
+- (CGFloat)baseline
+{
+  return _baseline;
+}
+
 #pragma mark - Drawing
 
 - (void)drawInContext:(CGContextRef)context bounds:(CGRect)bounds
@@ -109,8 +158,11 @@ static NSCharacterSet *_defaultAvoidTruncationCharacterSet()
   [_shadower setShadowInContext:context];
   UIGraphicsPushContext(context);
 
+  // Only lay down the lines that can show up in the context, e.g. when drawing a single tile of tall text.
+  const CGRect drawRect = CGRectIntersection(bounds, CGContextGetClipBoundingBox(context));
+
   [_context performBlockWithLockedTextKitComponents:^(NSLayoutManager *layoutManager, NSTextStorage *textStorage, NSTextContainer *textContainer) {
-    NSRange glyphRange = [layoutManager glyphRangeForBoundingRect:bounds inTextContainer:textContainer];
+    NSRange glyphRange = [layoutManager glyphRangeForBoundingRect:drawRect inTextContainer:textContainer];
     [layoutManager drawBackgroundForGlyphRange:glyphRange atPoint:shadowInsetBounds.origin];
     [layoutManager drawGlyphsForGlyphRange:glyphRange atPoint:shadowInsetBounds.origin];
   }];
@@ -123,19 +175,7 @@ static NSCharacterSet *_defaultAvoidTruncationCharacterSet()
 
 - (NSUInteger)lineCount
 {
-  __block NSUInteger lineCount = 0;
-  [_context performBlockWithLockedTextKitComponents:^(NSLayoutManager *layoutManager, NSTextStorage *textStorage, NSTextContainer *textContainer) {
-    NSUInteger numberOfGlyphs = [layoutManager numberOfGlyphs];
-    for (NSRange lineRange = { 0, 0 }; NSMaxRange(lineRange) < numberOfGlyphs;) {
-      CGRect lineRect = [layoutManager lineFragmentRectForGlyphAtIndex:NSMaxRange(lineRange) effectiveRange:&lineRange];
-      if (CGRectIsEmpty(lineRect)) {
-        break;
-      }
-      lineCount++;
-    }
-  }];
-
-  return lineCount;
+  return _lineCount;
 }
 
 - (std::vector<NSRange>)visibleRanges
@@ -143,4 +183,9 @@ static NSCharacterSet *_defaultAvoidTruncationCharacterSet()
   return _truncater.visibleRanges;
 }
 
+- (BOOL)isTruncated
+{
+  return _truncated;
+}
+
 @end
@@ -65,8 +65,10 @@ namespace CK {
 
         CKTextKitAttributes attributes;
         CGSize constrainedSize;
+        /** The part of the text an entry covers, e.g. one tile of a tiled raster; null for the whole of it. */
+        CGRect region;
 
-        Key(CKTextKitAttributes a, CGSize cs);
+        Key(CKTextKitAttributes a, CGSize cs, CGRect r = CGRectNull);
 
         size_t hash;
 
@@ -75,6 +77,7 @@ namespace CK {
           // These comparisons are in a specific order to reduce the overall cost of this function.
           return hash == other.hash
           && CGSizeEqualToSize(constrainedSize, other.constrainedSize)
+          && CGRectEqualToRect(region, other.region)
           && attributes == other.attributes;
         }
       };
@@ -110,25 +113,34 @@ namespace CK {
        should likely be a couple MB.  If you are storing renderers it's a good idea to have it related to the visible
        length of the string (as a proxy for number of glyph artifacts).  For an example of usage please see ASTextNode
        or CKTextComponent.
+
+       The underlying concurrent cache is a template parameter; use Cache for a single-lock cache, or ShardedCache for
+       caches that are hit from several threads at once (see CK::ShardedConcurrentCacheImpl).
        */
-      struct Cache {
+      template <typename CacheImplT>
+      struct BasicCache {
       private:
-        CK::ConcurrentCacheImpl<const Key, id, KeyHasher> cache;
+        CacheImplT cache;
         ApplicationObserver *applicationObserver;
 
       public:
-        Cache(const std::string cacheName, const NSUInteger maxCost, const CGFloat compactionFactor) : cache(cacheName, maxCost, compactionFactor) {
+        BasicCache(const std::string cacheName, const NSUInteger maxCost, const CGFloat compactionFactor) : cache(cacheName, maxCost, compactionFactor) {
           applicationObserver = new ApplicationObserver([this] {
-            compact(0.95);
+            cache.compact(0.95, CK::CacheEvictionReason::memoryWarning);
           }, [this] {
             removeAllObjects();
           });
         };
 
-        ~Cache() {
+        ~BasicCache() {
           delete applicationObserver;
         }
 
+        /** Direct access to the underlying cache, e.g. to tune ShardedConcurrentCacheImpl's touch sampling. */
+        CacheImplT &implementation() {
+          return cache;
+        }
+
         void cacheObject(const Key &key, id object, size_t cost) {
           cache.insert(key, object, cost);
         }
@@ -144,7 +156,19 @@ namespace CK {
         void removeAllObjects() {
           cache.removeAllObjects();
         }
+
+        CK::CacheStats stats() {
+          return cache.stats();
+        }
+
+        /** See CK::Cache::EvictionCallback; the callback runs under the cache lock and must not re-enter the cache. */
+        void setEvictionCallback(std::function<void(const Key &key, id object, CK::CacheEvictionReason reason)> callback) {
+          cache.setEvictionCallback(std::move(callback));
+        }
       };
+
+      typedef BasicCache<CK::ConcurrentCacheImpl<const Key, id, KeyHasher>> Cache;
+      typedef BasicCache<CK::ShardedConcurrentCacheImpl<const Key, id, KeyHasher>> ShardedCache;
     };
   };
 };
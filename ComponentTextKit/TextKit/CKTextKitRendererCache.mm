@@ -25,12 +25,14 @@ namespace CK {
     }
 
     namespace Renderer {
-      Key::Key(CKTextKitAttributes a, CGSize cs) : attributes(a), constrainedSize(cs) {
+      Key::Key(CKTextKitAttributes a, CGSize cs, CGRect r) : attributes(a), constrainedSize(cs), region(r) {
         // Precompute hash to avoid paying cost every time getHash is called.
         NSUInteger subhashes[] = {
           attributes.hash(),
           std::hash<CGFloat>()(constrainedSize.width),
-          std::hash<CGFloat>()(constrainedSize.height)
+          std::hash<CGFloat>()(constrainedSize.height),
+          std::hash<CGFloat>()(region.origin.y),
+          std::hash<CGFloat>()(region.size.height)
         };
         hash = CKIntegerArrayHash(subhashes, sizeof(subhashes) / sizeof(subhashes[0]));
       }
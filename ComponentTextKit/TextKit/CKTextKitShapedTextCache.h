@@ -0,0 +1,42 @@
+/*
+ *  Copyright (c) 2014-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+
+#import <UIKit/UIKit.h>
+
+#import <ComponentKit/CKCacheImpl.h>
+#import <ComponentKit/CKTextKitAttributes.h>
+
+namespace CK {
+  namespace TextKit {
+    /**
+     A width-independent cache of shaped text, keyed only by CKTextKitAttributes.
+
+     Building a CKTextKitRenderer creates a new NSTextStorage/NSLayoutManager and generates glyphs from scratch for
+     every constrained size, yet glyph generation does not depend on the width at all. Flexbox measures the same text
+     several times at different widths (AtMost then Exactly, rotation...), so these helpers keep one TextKit stack per
+     attributes whose glyphs are generated once, and only re-run line breaking when asked for a new size.
+
+     Results are identical to -[CKTextKitRenderer size] as long as the text is not truncated. When the text does not
+     fit, truncation needs to mutate the text storage, so measure() reports failure and callers should fall back to a
+     full renderer.
+     */
+    namespace ShapedText {
+      /**
+       Computes the size and, if requested, the first baseline a CKTextKitRenderer with these attributes and
+       constrained size would have.
+       @return false if the text would be truncated at this size, in which case size and baseline are left untouched.
+       */
+      bool measure(const CKTextKitAttributes &attributes, CGSize constrainedSize, CGSize *size, CGFloat *baseline = nullptr);
+
+      /** Counters for the shared shaped text cache. Costs are estimated bytes. */
+      CK::CacheStats cacheStats();
+    }
+  }
+}
@@ -0,0 +1,101 @@
+/*
+ *  Copyright (c) 2014-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+
+#import <ComponentKit/CKTextKitShapedTextCache.h>
+
+#import <ComponentKit/CKTextKitContext.h>
+#import <ComponentKit/CKTextKitCostEstimates.h>
+#import <ComponentKit/CKTextKitRendererCache.h>
+#import <ComponentKit/CKTextKitShadower.h>
+
+namespace CK {
+  namespace TextKit {
+    namespace ShapedText {
+      static Renderer::ShardedCache *sharedShapedTextCache()
+      {
+        // Entries hold a full TextKit stack, so this is budgeted in the same estimated bytes as the renderer cache.
+        static Renderer::ShardedCache *__shapedTextCache (new Renderer::ShardedCache("CKTextKitShapedTextCache", 2 * 1024 * 1024, 0.2));
+        return __shapedTextCache;
+      }
+
+      static CKTextKitContext *shapedContextForAttributes(const CKTextKitAttributes &attributes)
+      {
+        Renderer::ShardedCache *cache = sharedShapedTextCache();
+        // The shaped text is width independent, so it is stored under a zero constrained size.
+        const Renderer::Key key {attributes, CGSizeZero};
+        CKTextKitContext *context = cache->objectForKey(key);
+        if (!context) {
+          context = [[CKTextKitContext alloc] initWithAttributedString:attributes.attributedString
+                                                         lineBreakMode:attributes.lineBreakMode
+                                                  maximumNumberOfLines:attributes.maximumNumberOfLines
+                                                       constrainedSize:CGSizeZero
+                                                  layoutManagerFactory:attributes.layoutManagerFactory];
+          __block NSUInteger cost = 0;
+          [context performBlockWithLockedTextKitComponents:^(NSLayoutManager *layoutManager, NSTextStorage *textStorage, NSTextContainer *textContainer) {
+            // Asking for the glyph count generates the glyphs for the whole string; this is the work we want to share.
+            cost = kCKTextKitBaseCost
+            + textStorage.length * kCKTextKitCostPerCharacter
+            + [layoutManager numberOfGlyphs] * kCKTextKitCostPerGlyph;
+          }];
+          cache->cacheObject(key, context, cost);
+        }
+        return context;
+      }
+
+      bool measure(const CKTextKitAttributes &attributes, CGSize constrainedSize, CGSize *size, CGFloat *baseline)
+      {
+        CKTextKitShadower *shadower = [[CKTextKitShadower alloc] initWithShadowOffset:attributes.shadowOffset
+                                                                          shadowColor:attributes.shadowColor
+                                                                        shadowOpacity:attributes.shadowOpacity
+                                                                         shadowRadius:attributes.shadowRadius];
+        const CGSize shadowConstrainedSize = [shadower insetSizeWithConstrainedSize:constrainedSize];
+
+        __block BOOL truncated = NO;
+        __block CGRect boundingRect;
+        __block CGFloat internalBaseline = 0;
+        __block BOOL hasLines = NO;
+        [shapedContextForAttributes(attributes) performBlockWithLockedTextKitComponents:^(NSLayoutManager *layoutManager, NSTextStorage *textStorage, NSTextContainer *textContainer) {
+          // Resizing the container only invalidates layout, the generated glyphs are kept.
+          textContainer.size = shadowConstrainedSize;
+          [layoutManager ensureLayoutForTextContainer:textContainer];
+
+          NSRange visibleGlyphRange = [layoutManager glyphRangeForBoundingRect:{ .size = shadowConstrainedSize }
+                                                               inTextContainer:textContainer];
+          NSRange visibleCharacterRange = [layoutManager characterRangeForGlyphRange:visibleGlyphRange
+                                                                    actualGlyphRange:NULL];
+          truncated = visibleCharacterRange.length < textStorage.length && attributes.truncationAttributedString.length > 0;
+          boundingRect = [layoutManager usedRectForTextContainer:textContainer];
+          if (baseline && visibleGlyphRange.length > 0) {
+            const CGRect firstLineRect = [layoutManager lineFragmentRectForGlyphAtIndex:0 effectiveRange:NULL];
+            internalBaseline = CGRectGetMinY(firstLineRect) + [layoutManager locationForGlyphAtIndex:0].y;
+            hasLines = !CGRectIsEmpty(firstLineRect);
+          }
+        }];
+
+        if (truncated) {
+          return false;
+        }
+        // Same clipping as -[CKTextKitRenderer _calculateSize].
+        boundingRect = CGRectIntersection(boundingRect, {.size = constrainedSize});
+        *size = [shadower outsetSizeWithInsetSize:boundingRect.size];
+        if (baseline) {
+          // Same as -[CKTextKitRenderer baseline].
+          *baseline = hasLines ? [shadower offsetPointWithInternalPoint:{0, internalBaseline}].y : 0;
+        }
+        return true;
+      }
+
+      CK::CacheStats cacheStats()
+      {
+        return sharedShapedTextCache()->stats();
+      }
+    }
+  }
+}
@@ -9,10 +9,123 @@
  */
 
 #import <ComponentKit/CKAssert.h>
+#import <ComponentKit/CKCacheImpl.h>
+#import <ComponentKit/CKEqualityHashHelpers.h>
 
 #import <ComponentKit/CKTextKitContext.h>
 #import <ComponentKit/CKTextKitTailTruncater.h>
 
+namespace CK {
+  namespace TextKit {
+    namespace Truncation {
+      /**
+       The truncation message is nearly always the same few strings ("…", "… See More") measured at a handful of
+       widths, so measuring them once and sharing the result saves building a TextKit stack per truncated renderer.
+       */
+      struct MessageKey {
+        NSAttributedString *message;
+        CGSize constrainedSize;
+        size_t hash;
+
+        MessageKey(NSAttributedString *m, CGSize cs) : message(m), constrainedSize(cs) {
+          NSUInteger subhashes[] = {
+            [message hash],
+            std::hash<CGFloat>()(constrainedSize.width),
+            std::hash<CGFloat>()(constrainedSize.height)
+          };
+          hash = CKIntegerArrayHash(subhashes, sizeof(subhashes) / sizeof(subhashes[0]));
+        }
+
+        bool operator==(const MessageKey &other) const
+        {
+          return hash == other.hash
+          && CGSizeEqualToSize(constrainedSize, other.constrainedSize)
+          && (message == other.message || [message isEqual:other.message]);
+        }
+      };
+
+      struct MessageKeyHasher {
+        size_t operator()(const MessageKey &k) const
+        {
+          return k.hash;
+        }
+      };
+
+      static CK::ShardedConcurrentCacheImpl<const MessageKey, CGRect, MessageKeyHasher> *messageRectCache()
+      {
+        static auto *__messageRectCache = new CK::ShardedConcurrentCacheImpl<const MessageKey, CGRect, MessageKeyHasher>("CKTextKitTruncationMessageCache", 256, 0.2);
+        return __messageRectCache;
+      }
+
+      /** Returns the used rect of the truncation message laid out on a single line within constrainedSize. */
+      static CGRect usedRectForMessage(NSAttributedString *message, CGSize constrainedSize)
+      {
+        const MessageKey key {message, constrainedSize};
+        const CGRect cachedRect = messageRectCache()->find(key, CGRectNull);
+        if (!CGRectIsNull(cachedRect)) {
+          return cachedRect;
+        }
+
+        CKTextKitContext *truncationContext = [[CKTextKitContext alloc] initWithAttributedString:message
+                                                                                   lineBreakMode:NSLineBreakByWordWrapping
+                                                                            maximumNumberOfLines:1
+                                                                                 constrainedSize:constrainedSize
+                                                                            layoutManagerFactory:nil];
+        __block CGRect truncationUsedRect;
+        [truncationContext performBlockWithLockedTextKitComponents:^(NSLayoutManager *truncationLayoutManager, NSTextStorage *truncationTextStorage, NSTextContainer *truncationTextContainer) {
+          // Size the truncation message
+          [truncationLayoutManager ensureLayoutForTextContainer:truncationTextContainer];
+          NSRange truncationGlyphRange = [truncationLayoutManager glyphRangeForTextContainer:truncationTextContainer];
+          truncationUsedRect = [truncationLayoutManager boundingRectForGlyphRange:truncationGlyphRange
+                                                                  inTextContainer:truncationTextContainer];
+        }];
+        messageRectCache()->insert(key, truncationUsedRect, 1);
+        return truncationUsedRect;
+      }
+
+      /**
+       Whether any character in range belongs to a right-to-left script (Hebrew, Arabic, Syriac, Thaana, N'Ko and the
+       presentation forms). Such characters can appear in any paragraph, whatever its base writing direction.
+       */
+      static BOOL containsRightToLeftCharacters(NSString *string, NSRange range)
+      {
+        static NSCharacterSet *__rightToLeftCharacters = ^{
+          NSMutableCharacterSet *set = [NSMutableCharacterSet new];
+          [set addCharactersInRange:NSMakeRange(0x0590, 0x0900 - 0x0590)];
+          [set addCharactersInRange:NSMakeRange(0xFB1D, 0xFE00 - 0xFB1D)];
+          [set addCharactersInRange:NSMakeRange(0xFE70, 0xFF00 - 0xFE70)];
+          [set addCharactersInRange:NSMakeRange(0x10800, 0x11000 - 0x10800)];
+          [set addCharactersInRange:NSMakeRange(0x1E800, 0x1F000 - 0x1E800)];
+          return [set copy];
+        }();
+        return [string rangeOfCharacterFromSet:__rightToLeftCharacters options:0 range:range].location != NSNotFound;
+      }
+
+      /**
+       Left-to-right equivalent of -glyphIndexForPoint:inTextContainer: restricted to one line: the last glyph of the
+       line starting at or before x, or the first glyph if none does. Glyph origins only increase along a line without
+       right-to-left runs, so this is a binary search over glyph locations instead of a hit test.
+       */
+      static NSUInteger glyphIndexForHorizontalOffsetInLine(NSLayoutManager *layoutManager, NSRange lineGlyphRange,
+                                                            CGRect lineRect, CGFloat x)
+      {
+        NSUInteger low = lineGlyphRange.location;
+        NSUInteger high = NSMaxRange(lineGlyphRange);
+        // Invariant: every glyph before low starts at or before x, every glyph from high on starts after it.
+        while (low < high) {
+          const NSUInteger mid = low + (high - low) / 2;
+          if (CGRectGetMinX(lineRect) + [layoutManager locationForGlyphAtIndex:mid].x <= x) {
+            low = mid + 1;
+          } else {
+            high = mid;
+          }
+        }
+        return low > lineGlyphRange.location ? low - 1 : lineGlyphRange.location;
+      }
+    }
+  }
+}
+
 @implementation CKTextKitTailTruncater
 {
   __weak CKTextKitContext *_context;
@@ -56,8 +169,9 @@
     return NSNotFound;
   }
 
+  NSRange lastLineGlyphRange;
   CGRect lastLineRect = [layoutManager lineFragmentRectForGlyphAtIndex:lastVisibleGlyphIndex
-                                                        effectiveRange:NULL];
+                                                        effectiveRange:&lastLineGlyphRange];
   CGRect lastLineUsedRect = [layoutManager lineFragmentUsedRectForGlyphAtIndex:lastVisibleGlyphIndex
                                                                 effectiveRange:NULL];
   NSParagraphStyle *paragraphStyle = [textStorage attributesAtIndex:[layoutManager characterIndexForGlyphAtIndex:lastVisibleGlyphIndex]
@@ -69,21 +183,8 @@
   BOOL leftAligned = CGRectGetMinX(lastLineRect) == CGRectGetMinX(lastLineUsedRect) || !rtlWritingDirection;
 
   // Calculate the bounding rectangle for the truncation message
-  CKTextKitContext *truncationContext = [[CKTextKitContext alloc] initWithAttributedString:_truncationAttributedString
-                                                                             lineBreakMode:NSLineBreakByWordWrapping
-                                                                      maximumNumberOfLines:1
-                                                                           constrainedSize:constrainedRect.size
-                                                                      layoutManagerFactory:nil];
-
-  __block CGRect truncationUsedRect;
-
-  [truncationContext performBlockWithLockedTextKitComponents:^(NSLayoutManager *truncationLayoutManager, NSTextStorage *truncationTextStorage, NSTextContainer *truncationTextContainer) {
-    // Size the truncation message
-    [truncationLayoutManager ensureLayoutForTextContainer:truncationTextContainer];
-    NSRange truncationGlyphRange = [truncationLayoutManager glyphRangeForTextContainer:truncationTextContainer];
-    truncationUsedRect = [truncationLayoutManager boundingRectForGlyphRange:truncationGlyphRange
-                                                            inTextContainer:truncationTextContainer];
-  }];
+  const CGRect truncationUsedRect = CK::TextKit::Truncation::usedRectForMessage(_truncationAttributedString,
+                                                                                constrainedRect.size);
   CGFloat truncationOriginX = (leftAligned ?
                                CGRectGetMaxX(constrainedRect) - truncationUsedRect.size.width :
                                CGRectGetMinX(constrainedRect));
@@ -98,9 +199,25 @@
                                 CGRectGetMaxX(translatedTruncationRect));
   CGPoint beginningOfTruncationMessage = CGPointMake(truncationMessageX,
                                                      CGRectGetMidY(translatedTruncationRect));
-  NSUInteger firstClippedGlyphIndex = [layoutManager glyphIndexForPoint:beginningOfTruncationMessage
-                                                        inTextContainer:textContainer
-                                         fractionOfDistanceThroughGlyph:NULL];
+  // A line can hold right-to-left runs even when the paragraph does not set an RTL writing direction (natural
+  // direction, or mixed-direction text), so check the characters of the line rather than the paragraph style.
+  const NSRange lastLineCharacterRange = [layoutManager characterRangeForGlyphRange:lastLineGlyphRange
+                                                                   actualGlyphRange:NULL];
+  const BOOL lastLineIsLeftToRight =
+  !rtlWritingDirection
+  && !CK::TextKit::Truncation::containsRightToLeftCharacters(textStorage.string, lastLineCharacterRange);
+  NSUInteger firstClippedGlyphIndex;
+  if (lastLineIsLeftToRight) {
+    firstClippedGlyphIndex = CK::TextKit::Truncation::glyphIndexForHorizontalOffsetInLine(layoutManager,
+                                                                                          lastLineGlyphRange,
+                                                                                          lastLineRect,
+                                                                                          beginningOfTruncationMessage.x);
+  } else {
+    // Glyph origins aren't monotonic in lines with RTL runs, so let TextKit hit test.
+    firstClippedGlyphIndex = [layoutManager glyphIndexForPoint:beginningOfTruncationMessage
+                                               inTextContainer:textContainer
+                                fractionOfDistanceThroughGlyph:NULL];
+  }
   // If it didn't intersect with any text then it should just return the last visible character index, since the
   // truncation rect can fully fit on the line without clipping any other text.
   if (firstClippedGlyphIndex == NSNotFound) {
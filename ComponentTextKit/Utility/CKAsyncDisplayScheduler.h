@@ -0,0 +1,83 @@
+/*
+ *  Copyright (c) 2014-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+
+
+#import <Foundation/Foundation.h>
+
+#import <ComponentKit/CKAsyncTransaction.h>
+
+typedef NS_ENUM(NSUInteger, CKAsyncDisplayPriority) {
+  /** Content that is on screen right now. */
+  CKAsyncDisplayPriorityVisible,
+  /** Content within about a screen of the visible area, which scrolling is about to reveal. */
+  CKAsyncDisplayPriorityNearVisible,
+  /** Everything else, e.g. cells being prepared in a collection view's prefetch range or content not in a window. */
+  CKAsyncDisplayPriorityPrefetch,
+};
+
+/**
+ @summary Runs asynchronous display work in priority order on a bounded number of workers.
+
+ @desc Work is queued in one lane per CKAsyncDisplayPriority. Workers always drain the most urgent non-empty lane first,
+ and within a lane take the most recently scheduled operation first (LIFO): when the user scrolls quickly, what was
+ requested last is what is about to be on screen, while older requests are likely to have scrolled away already.
+
+ Operations are tagged with the display sentinel of the layer that scheduled them. Once the sentinel moves on they are
+ considered cancelled: -cancelOperationsWithDisplaySentinel: takes them out of the queue right away, and workers skip
+ any stale operation they dequeue. Either way the operation's cancellation block runs instead of its work block.
+ */
+@interface CKAsyncDisplayScheduler : NSObject
+
+/** The scheduler used by CKAsyncLayer, running at most as many operations at once as there are active processors. */
++ (instancetype)sharedScheduler;
+
+- (instancetype)initWithMaximumConcurrentOperations:(NSUInteger)maximumConcurrentOperations NS_DESIGNATED_INITIALIZER;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/**
+ Enqueues work. Thread safe.
+
+ @param block The work; runs on a background queue.
+ @param cancellation Runs, on an arbitrary thread, instead of block if the operation is cancelled before it starts.
+ @param priority The lane to queue the operation in.
+ @param displaySentinel The sentinel of the layer the work is for, or NULL if it can't be cancelled.
+ @param expectedDisplaySentinelValue The operation is cancelled once *displaySentinel no longer has this value.
+ */
+- (void)scheduleBlock:(dispatch_block_t)block
+         cancellation:(dispatch_block_t)cancellation
+             priority:(CKAsyncDisplayPriority)priority
+      displaySentinel:(int32_t *)displaySentinel
+expectedDisplaySentinelValue:(int32_t)expectedDisplaySentinelValue;
+
+/**
+ Wraps an operation block so that it can be added to a CKAsyncTransaction with
+ -addScheduledOperationWithBlock:queue:completion:, using transactionQueue, and run through the scheduler. The
+ operation reports when a worker actually ran it, or completes with nil as canceled if it is cancelled.
+ */
+- (ck_async_transaction_scheduled_operation_block_t)transactionOperationWithBlock:(ck_async_transaction_operation_block_t)block
+                                                                     priority:(CKAsyncDisplayPriority)priority
+                                                              displaySentinel:(int32_t *)displaySentinel
+                                                 expectedDisplaySentinelValue:(int32_t)expectedDisplaySentinelValue;
+
+/**
+ A serial queue that only hands operations over to the scheduler, to pass to CKAsyncTransaction along with the blocks
+ returned by -transactionOperationWithBlock:priority:displaySentinel:expectedDisplaySentinelValue:.
+ */
+@property (nonatomic, readonly) dispatch_queue_t transactionQueue;
+
+/**
+ Removes every queued operation tagged with displaySentinel whose expected value no longer matches it, and runs their
+ cancellation blocks. Operations that have already started are not affected. Queued operations are indexed by
+ sentinel, so this only looks at the operations of that sentinel, not at the whole queue.
+ */
+- (void)cancelOperationsWithDisplaySentinel:(int32_t *)displaySentinel;
+
+@end
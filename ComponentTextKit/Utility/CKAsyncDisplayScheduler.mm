@@ -0,0 +1,219 @@
+/*
+ *  Copyright (c) 2014-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+
+
+#import "CKAsyncDisplayScheduler.h"
+
+#import <algorithm>
+#import <deque>
+#import <memory>
+#import <unordered_map>
+#import <vector>
+
+#import <QuartzCore/QuartzCore.h>
+
+#import <ComponentKit/CKMutex.h>
+
+namespace CK {
+  namespace AsyncDisplay {
+    struct Operation {
+      dispatch_block_t block;
+      dispatch_block_t cancellation;
+      int32_t *displaySentinel;
+      int32_t expectedDisplaySentinelValue;
+      /** Set under the scheduler's mutex once a worker or a cancellation has taken the operation; lanes skip it then. */
+      bool taken;
+
+      bool isCancelled() const
+      {
+        return displaySentinel != nullptr && *displaySentinel != expectedDisplaySentinelValue;
+      }
+    };
+
+    static const NSUInteger kNumberOfPriorities = CKAsyncDisplayPriorityPrefetch + 1;
+  }
+}
+
+@implementation CKAsyncDisplayScheduler
+{
+  NSUInteger _maximumConcurrentOperations;
+  dispatch_queue_t _workerQueue;
+
+  CK::Mutex _mutex;
+  // Guarded by _mutex. The back of each lane is the most recently scheduled operation. Operations cancelled through
+  // their sentinel stay in their lane, marked as taken, until a worker pops them.
+  std::deque<std::shared_ptr<CK::AsyncDisplay::Operation>> _lanes[CK::AsyncDisplay::kNumberOfPriorities];
+  // Guarded by _mutex. The operations not taken yet, by display sentinel, so that a layer cancels its operations
+  // without scanning every lane.
+  std::unordered_map<int32_t *, std::vector<std::shared_ptr<CK::AsyncDisplay::Operation>>> _operationsBySentinel;
+  NSUInteger _activeWorkers;
+}
+
++ (instancetype)sharedScheduler
+{
+  static CKAsyncDisplayScheduler *sharedScheduler;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    sharedScheduler = [[CKAsyncDisplayScheduler alloc] initWithMaximumConcurrentOperations:[NSProcessInfo processInfo].activeProcessorCount];
+  });
+  return sharedScheduler;
+}
+
+- (instancetype)initWithMaximumConcurrentOperations:(NSUInteger)maximumConcurrentOperations
+{
+  if (self = [super init]) {
+    _maximumConcurrentOperations = MAX(maximumConcurrentOperations, 1u);
+    _workerQueue = dispatch_queue_create("com.facebook.CKAsyncDisplayScheduler.worker", DISPATCH_QUEUE_CONCURRENT);
+    // We use the highpri queue to prioritize UI rendering over other async operations.
+    dispatch_set_target_queue(_workerQueue, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_HIGH, 0));
+    _transactionQueue = dispatch_queue_create("com.facebook.CKAsyncDisplayScheduler.transaction", DISPATCH_QUEUE_SERIAL);
+  }
+  return self;
+}
+
+- (void)scheduleBlock:(dispatch_block_t)block
+         cancellation:(dispatch_block_t)cancellation
+             priority:(CKAsyncDisplayPriority)priority
+      displaySentinel:(int32_t *)displaySentinel
+expectedDisplaySentinelValue:(int32_t)expectedDisplaySentinelValue
+{
+  BOOL startWorker = NO;
+  {
+    CK::MutexLocker l(_mutex);
+    auto operation = std::make_shared<CK::AsyncDisplay::Operation>(CK::AsyncDisplay::Operation {
+      [block copy],
+      [cancellation copy],
+      displaySentinel,
+      expectedDisplaySentinelValue,
+      false,
+    });
+    _lanes[MIN(priority, CKAsyncDisplayPriorityPrefetch)].push_back(operation);
+    if (displaySentinel) {
+      _operationsBySentinel[displaySentinel].push_back(operation);
+    }
+    if (_activeWorkers < _maximumConcurrentOperations) {
+      _activeWorkers++;
+      startWorker = YES;
+    }
+  }
+  if (startWorker) {
+    dispatch_async(_workerQueue, ^{
+      [self _drainLanes];
+    });
+  }
+}
+
+- (ck_async_transaction_scheduled_operation_block_t)transactionOperationWithBlock:(ck_async_transaction_operation_block_t)block
+                                                                         priority:(CKAsyncDisplayPriority)priority
+                                                                  displaySentinel:(int32_t *)displaySentinel
+                                                     expectedDisplaySentinelValue:(int32_t)expectedDisplaySentinelValue
+{
+  return [^(ck_async_transaction_complete_scheduled_operation_block_t completeOperationBlock) {
+    [self scheduleBlock:^{
+      // Timed here, by the worker, so that the time spent in a lane counts as queue wait.
+      const CFTimeInterval startTime = CACurrentMediaTime();
+      id<NSObject> value = block();
+      completeOperationBlock(value, startTime, CACurrentMediaTime(), NO);
+    } cancellation:^{
+      completeOperationBlock(nil, 0, 0, YES);
+    } priority:priority displaySentinel:displaySentinel expectedDisplaySentinelValue:expectedDisplaySentinelValue];
+  } copy];
+}
+
+- (void)cancelOperationsWithDisplaySentinel:(int32_t *)displaySentinel
+{
+  std::vector<dispatch_block_t> cancellations;
+  {
+    CK::MutexLocker l(_mutex);
+    const auto operations = _operationsBySentinel.find(displaySentinel);
+    if (operations == _operationsBySentinel.end()) {
+      return;
+    }
+    auto &pending = operations->second;
+    for (auto it = pending.begin(); it != pending.end();) {
+      if ((*it)->isCancelled()) {
+        (*it)->taken = true;
+        cancellations.push_back((*it)->cancellation);
+        // The lane keeps the operation until a worker pops it; don't keep what the blocks captured alive until then.
+        (*it)->block = nil;
+        (*it)->cancellation = nil;
+        it = pending.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    if (pending.empty()) {
+      _operationsBySentinel.erase(operations);
+    }
+  }
+  // Cancellation blocks complete transaction operations, so they must not run under the lock.
+  for (const auto &cancellation : cancellations) {
+    if (cancellation) {
+      cancellation();
+    }
+  }
+}
+
+#pragma mark - Workers
+
+- (void)_drainLanes
+{
+  while (true) {
+    std::shared_ptr<CK::AsyncDisplay::Operation> operation;
+    {
+      CK::MutexLocker l(_mutex);
+      while (!operation) {
+        auto lane = std::find_if(std::begin(_lanes), std::end(_lanes), [](const std::deque<std::shared_ptr<CK::AsyncDisplay::Operation>> &l) {
+          return !l.empty();
+        });
+        if (lane == std::end(_lanes)) {
+          _activeWorkers--;
+          return;
+        }
+        auto candidate = std::move(lane->back());
+        lane->pop_back();
+        if (!candidate->taken) {
+          candidate->taken = true;
+          [self _forgetOperation:candidate];
+          operation = std::move(candidate);
+        }
+      }
+    }
+
+    @autoreleasepool {
+      if (operation->isCancelled()) {
+        if (operation->cancellation) {
+          operation->cancellation();
+        }
+      } else {
+        operation->block();
+      }
+    }
+  }
+}
+
+/** Must be called under _mutex. Only scans the operations of the same sentinel, usually one or two. */
+- (void)_forgetOperation:(const std::shared_ptr<CK::AsyncDisplay::Operation> &)operation
+{
+  if (operation->displaySentinel == nullptr) {
+    return;
+  }
+  const auto operations = _operationsBySentinel.find(operation->displaySentinel);
+  if (operations == _operationsBySentinel.end()) {
+    return;
+  }
+  auto &pending = operations->second;
+  pending.erase(std::remove(pending.begin(), pending.end(), operation), pending.end());
+  if (pending.empty()) {
+    _operationsBySentinel.erase(operations);
+  }
+}
+
+@end
@@ -28,6 +28,21 @@ typedef NS_ENUM(NSUInteger, CKAsyncLayerDisplayMode) {
  */
 @property (atomic, assign) CKAsyncLayerDisplayMode displayMode;
 
+/**
+ @summary When positive, content taller than this is drawn as a column of tiles of this height instead of a single
+ bitmap covering the whole bounds.
+
+ @desc Each tile is rasterized into its own sublayer, and only the tiles intersecting the visible rect (plus one tile of
+ lookahead on either side) are drawn. Off-screen tiles are dropped on memory warnings. The layer can't observe
+ scrolling, so call -updateVisibleTiles whenever the visible portion changes, e.g. from scrollViewDidScroll:.
+
+ Tiles go through the same sync/async decision as regular display, and the subclass hooks
+ -willDisplayTileAsynchronouslyInRect:withDrawParameters: and -didDisplayTileAsynchronously:inRect:withDrawParameters:.
+
+ @default 0, which disables tiling.
+ */
+@property (atomic, assign) CGFloat tileHeight;
+
 /**
  @summary Captures parameters from the receiver on the main thread that will be passed to drawInContext:parameters:
  on a background queue.  Override to capture values from any properties that are needed for drawing.
@@ -71,4 +86,10 @@ typedef NS_ENUM(NSUInteger, CKAsyncLayerDisplayMode) {
  */
 - (void)setNeedsAsyncDisplay;
 
+/**
+ Draws any tile that has become visible since the last display. Does nothing unless the layer is currently tiled; see
+ tileHeight.
+ */
+- (void)updateVisibleTiles;
+
 @end
@@ -16,33 +16,46 @@
 
 #import <ComponentKit/CKAssert.h>
 
+#import "CKAsyncDisplayScheduler.h"
+#import "CKBitmapBufferPool.h"
 #import "CKAsyncTransaction.h"
 #import "CKAsyncTransactionContainer.h"
 
-@implementation CKAsyncLayer
+/** Holds the contents of one tile; never animates. */
+@interface CKAsyncLayerTile : CALayer
+@end
+
+@implementation CKAsyncLayerTile
+
+- (id<CAAction>)actionForKey:(NSString *)event
 {
-  BOOL _needsAsyncDisplayOnly;
+  return nil;
 }
 
-#pragma mark - Class Methods
+@end
 
-+ (dispatch_queue_t)displayQueue
+@implementation CKAsyncLayer
 {
-  static dispatch_queue_t displayQueue = NULL;
-  static dispatch_once_t onceToken;
-  dispatch_once(&onceToken, ^{
-    displayQueue = dispatch_queue_create("com.facebook.CKAsyncLayer.display", DISPATCH_QUEUE_CONCURRENT);
-    // we use the highpri queue to prioritize UI rendering over other async operations
-    dispatch_set_target_queue(displayQueue, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_HIGH, 0));
-  });
+  BOOL _needsAsyncDisplayOnly;
 
-  return displayQueue;
+  // Tiled display state, only touched on the main thread. See tileHeight.
+  NSMutableDictionary<NSNumber *, CALayer *> *_tiles;
+  NSMutableIndexSet *_pendingTiles;
+  NSMutableIndexSet *_staleTiles;
+  NSObject *_tileDrawParameters;
+  BOOL _tilesRenderSynchronously;
+  int32_t _tileDisplaySentinelValue;
+  BOOL _observingMemoryWarnings;
 }
 
+#pragma mark - Class Methods
+
 + (id)defaultValueForKey:(NSString *)key
 {
   if ([key isEqualToString:@"displayMode"]) {
     return @(CKAsyncLayerDisplayModeDefault);
+  } else if ([key isEqualToString:@"tileHeight"]) {
+    return @(0);
   } else {
     return [super defaultValueForKey:key];
   }
@@ -56,6 +69,16 @@
 }
 
 @dynamic displayMode;
+@dynamic tileHeight;
+
+- (void)dealloc
+{
+  if (_observingMemoryWarnings) {
+    [[NSNotificationCenter defaultCenter] removeObserver:self
+                                                    name:UIApplicationDidReceiveMemoryWarningNotification
+                                                  object:nil];
+  }
+}
 
 - (void)setNeedsDisplay
 {
@@ -88,6 +111,47 @@
 {
   CKAssertMainThread();
   OSAtomicIncrement32(&_displaySentinel);
+  // Don't leave the stale work queued behind displays that are still wanted.
+  [[CKAsyncDisplayScheduler sharedScheduler] cancelOperationsWithDisplaySentinel:&_displaySentinel];
+}
+
+/** The root layer's bounds in the receiver's coordinate space, or CGRectNull if the receiver isn't in a layer tree. */
+- (CGRect)_rootVisibleRect
+{
+  CALayer *rootLayer = self;
+  while (rootLayer.superlayer) {
+    rootLayer = rootLayer.superlayer;
+  }
+  return rootLayer == self ? CGRectNull : [self convertRect:rootLayer.bounds fromLayer:rootLayer];
+}
+
+- (CKAsyncDisplayPriority)_displayPriority
+{
+  const CGRect visibleRect = [self _rootVisibleRect];
+  if (CGRectIsNull(visibleRect)) {
+    return CKAsyncDisplayPriorityPrefetch;
+  }
+  const CGRect bounds = self.bounds;
+  if (CGRectIntersectsRect(visibleRect, bounds)) {
+    return CKAsyncDisplayPriorityVisible;
+  }
+  // Within a screen's worth of scrolling in any direction.
+  const CGRect nearVisibleRect = CGRectInset(visibleRect, -CGRectGetWidth(visibleRect), -CGRectGetHeight(visibleRect));
+  return CGRectIntersectsRect(nearVisibleRect, bounds) ? CKAsyncDisplayPriorityNearVisible : CKAsyncDisplayPriorityPrefetch;
+}
+
+- (void)_addDisplayBlock:(ck_async_transaction_operation_block_t)displayBlock
+           toTransaction:(CKAsyncTransaction *)transaction
+           sentinelValue:(int32_t)displaySentinelValue
+              completion:(ck_async_transaction_operation_completion_block_t)completion
+{
+  CKAsyncDisplayScheduler *scheduler = [CKAsyncDisplayScheduler sharedScheduler];
+  [transaction addScheduledOperationWithBlock:[scheduler transactionOperationWithBlock:displayBlock
+                                                                              priority:[self _displayPriority]
+                                                                       displaySentinel:&_displaySentinel
+                                                          expectedDisplaySentinelValue:displaySentinelValue]
+                                        queue:scheduler.transactionQueue
+                                   completion:completion];
 }
 
 + (ck_async_transaction_operation_block_t)asyncDisplayBlockWithBounds:(CGRect)bounds
@@ -111,8 +175,16 @@
       return nil;
     }
 
-    UIGraphicsBeginImageContextWithOptions(bounds.size, opaque, contentsScale);
-    CGContextRef bitmapContext = UIGraphicsGetCurrentContext();
+    // An opaque background fill overwrites every pixel, so a recycled buffer doesn't need clearing first.
+    const BOOL coveredByBackground = opaque && backgroundColorObject != NULL
+    && CGColorGetAlpha((CGColorRef)backgroundColorObject) == 1.0;
+    CGContextRef bitmapContext = CK::BitmapBufferPool::createContext(bounds.size, contentsScale, opaque, !coveredByBackground);
+    if (bitmapContext == NULL) {
+      return nil;
+    }
+    UIGraphicsPushContext(bitmapContext);
+    // Tiles only cover part of the content; shift it so the tile's rect lands on the bitmap.
+    CGContextTranslateCTM(bitmapContext, -bounds.origin.x, -bounds.origin.y);
 
     if (backgroundColorObject != NULL) {
       CGContextSetFillColorWithColor(bitmapContext, (CGColorRef)backgroundColorObject);
@@ -121,8 +193,10 @@
 
     [drawingDelegate drawAsyncLayerInContext:bitmapContext parameters:drawParameters];
 
-    CGImageRef image = CGBitmapContextCreateImage(bitmapContext);
-    UIGraphicsEndImageContext();
+    UIGraphicsPopContext();
+    // Wraps the pooled buffer instead of copying it; the buffer is recycled once the image is released.
+    CGImageRef image = CK::BitmapBufferPool::createImage(bitmapContext);
+    CGContextRelease(bitmapContext);
 
     return CFBridgingRelease(image);
   } copy];
@@ -134,6 +208,7 @@
 
   BOOL renderSynchronously = NO;
   CALayer *parentTransactionContainer;
+  const BOOL asyncDisplayOnly = _needsAsyncDisplayOnly;
 
   if (!_needsAsyncDisplayOnly) {
     switch (self.displayMode) {
@@ -151,7 +226,9 @@
     }
   }
 
-  if (renderSynchronously) {
+  const BOOL tiled = [self _shouldTileBounds:self.bounds];
+  if (renderSynchronously && !tiled) {
+    [self _removeAllTiles];
     [super display];
     return;
   }
@@ -171,15 +248,24 @@
   NSObject *drawParameters = [self drawParameters];
   id shortCircuitContents = [self willDisplayAsynchronouslyWithDrawParameters:drawParameters];
   if (shortCircuitContents) {
+    [self _removeAllTiles];
     self.contents = shortCircuitContents;
     return;
   }
 
+  if (tiled) {
+    [self _displayTilesWithDrawParameters:drawParameters
+                            synchronously:renderSynchronously
+                         keepStaleContents:asyncDisplayOnly];
+    return;
+  }
+  [self _removeAllTiles];
+
   int32_t displaySentinelValue = OSAtomicIncrement32(&_displaySentinel);
   CALayer *containerLayer = parentTransactionContainer ?: self;
   CKAsyncTransaction *transaction = containerLayer.ck_asyncTransaction;
   CKAssertNotNil(transaction, @"Expected async layer transaction to be non-nil");
-  ck_async_transaction_operation_block_t transactionBlock = [[self class] asyncDisplayBlockWithBounds:bounds
+  ck_async_transaction_operation_block_t transactionBlock = [[self class] asyncDisplayBlockWithBounds:{.size = bounds.size}
                                                                                         contentsScale:self.contentsScale
                                                                                                opaque:self.opaque
                                                                                       backgroundColor:self.backgroundColor
@@ -194,7 +280,7 @@
       self.contents = value;
     }
   };
-  [transaction addOperationWithBlock:transactionBlock queue:[[self class] displayQueue] completion:completionBlock];
+  [self _addDisplayBlock:transactionBlock toTransaction:transaction sentinelValue:displaySentinelValue completion:completionBlock];
 }
 
 - (id)willDisplayAsynchronouslyWithDrawParameters:(id<NSObject>)drawParameters
@@ -206,6 +292,224 @@
 {
 }
 
+- (id)willDisplayTileAsynchronouslyInRect:(CGRect)tileRect withDrawParameters:(id<NSObject>)drawParameters
+{
+  return nil;
+}
+
+- (void)didDisplayTileAsynchronously:(id)newContents inRect:(CGRect)tileRect withDrawParameters:(id<NSObject>)drawParameters
+{
+}
+
+#pragma mark - Tiles
+
+- (BOOL)_shouldTileBounds:(CGRect)bounds
+{
+  const CGFloat tileHeight = self.tileHeight;
+  return tileHeight > 0 && CGRectGetHeight(bounds) > tileHeight;
+}
+
+- (NSUInteger)_numberOfTiles
+{
+  return (NSUInteger)ceil(CGRectGetHeight(self.bounds) / self.tileHeight);
+}
+
+/** In the same space as the display block's bounds: relative to the top-left of the layer's bounds. */
+- (CGRect)_rectForTileAtIndex:(NSUInteger)index
+{
+  const CGSize size = self.bounds.size;
+  const CGFloat tileHeight = self.tileHeight;
+  const CGFloat minY = index * tileHeight;
+  return {{0, minY}, {size.width, MIN(tileHeight, size.height - minY)}};
+}
+
+/** The tiles intersecting the part of the layer that is on screen, plus one tile on either side. */
+- (NSRange)_visibleTileRange
+{
+  const NSUInteger numberOfTiles = [self _numberOfTiles];
+  const CGRect bounds = self.bounds;
+  const CGFloat tileHeight = self.tileHeight;
+
+  CGRect visibleRect = [self _rootVisibleRect];
+  if (CGRectIsNull(visibleRect)) {
+    // Not in a layer tree yet; the top is what will show first.
+    return NSMakeRange(0, MIN(2, numberOfTiles));
+  }
+  visibleRect = CGRectOffset(visibleRect, -bounds.origin.x, -bounds.origin.y);
+  NSInteger firstTile;
+  NSInteger lastTile;
+  if (CGRectGetMaxY(visibleRect) <= 0) {
+    // Entirely below the screen: the top scrolls in first.
+    firstTile = lastTile = 0;
+  } else if (CGRectGetMinY(visibleRect) >= bounds.size.height) {
+    // Entirely above the screen: the bottom scrolls in first.
+    firstTile = lastTile = numberOfTiles - 1;
+  } else {
+    firstTile = (NSInteger)floor(CGRectGetMinY(visibleRect) / tileHeight);
+    lastTile = (NSInteger)ceil(CGRectGetMaxY(visibleRect) / tileHeight) - 1;
+  }
+  firstTile = MAX(firstTile - 1, 0);
+  lastTile = MIN(lastTile + 1, (NSInteger)numberOfTiles - 1);
+  return NSMakeRange(firstTile, lastTile - firstTile + 1);
+}
+
+- (void)_displayTilesWithDrawParameters:(NSObject *)drawParameters
+                          synchronously:(BOOL)synchronously
+                       keepStaleContents:(BOOL)keepStaleContents
+{
+  self.contents = nil;
+
+  _tileDrawParameters = drawParameters;
+  _tilesRenderSynchronously = synchronously;
+  _tileDisplaySentinelValue = OSAtomicIncrement32(&_displaySentinel);
+  _pendingTiles = [NSMutableIndexSet indexSet];
+  _staleTiles = [NSMutableIndexSet indexSet];
+
+  const NSUInteger numberOfTiles = [self _numberOfTiles];
+  const NSRange visibleTiles = [self _visibleTileRange];
+  for (NSNumber *index in [_tiles allKeys]) {
+    const NSUInteger i = index.unsignedIntegerValue;
+    // Out of date tiles are only worth keeping while they're on screen and about to be replaced.
+    if (keepStaleContents && NSLocationInRange(i, visibleTiles) && i < numberOfTiles) {
+      [_staleTiles addIndex:i];
+      _tiles[index].frame = CGRectOffset([self _rectForTileAtIndex:i], self.bounds.origin.x, self.bounds.origin.y);
+    } else {
+      [_tiles[index] removeFromSuperlayer];
+      [_tiles removeObjectForKey:index];
+    }
+  }
+
+  if (!_observingMemoryWarnings) {
+    _observingMemoryWarnings = YES;
+    [[NSNotificationCenter defaultCenter] addObserver:self
+                                             selector:@selector(_didReceiveMemoryWarning:)
+                                                 name:UIApplicationDidReceiveMemoryWarningNotification
+                                               object:nil];
+  }
+
+  [self updateVisibleTiles];
+}
+
+- (void)updateVisibleTiles
+{
+  CKAssertMainThread();
+  if (!_tileDrawParameters || ![self _shouldTileBounds:self.bounds]) {
+    return;
+  }
+  if (_displaySentinel != _tileDisplaySentinelValue) {
+    // A cancellation dropped the tiles that were in flight; start a new generation so they get drawn again.
+    _tileDisplaySentinelValue = OSAtomicIncrement32(&_displaySentinel);
+    [_pendingTiles removeAllIndexes];
+  }
+
+  const NSRange visibleTiles = [self _visibleTileRange];
+  for (NSUInteger i = visibleTiles.location; i < NSMaxRange(visibleTiles); i++) {
+    [self _displayTileAtIndex:i];
+  }
+}
+
+- (CALayer *)_tileLayerAtIndex:(NSUInteger)index
+{
+  if (!_tiles) {
+    _tiles = [NSMutableDictionary dictionary];
+  }
+  CALayer *tile = _tiles[@(index)];
+  if (!tile) {
+    tile = [CKAsyncLayerTile layer];
+    tile.contentsScale = self.contentsScale;
+    tile.opaque = self.opaque;
+    tile.frame = CGRectOffset([self _rectForTileAtIndex:index], self.bounds.origin.x, self.bounds.origin.y);
+    // Below anything a subclass adds, such as highlights.
+    [self insertSublayer:tile atIndex:0];
+    _tiles[@(index)] = tile;
+  }
+  return tile;
+}
+
+- (void)_displayTileAtIndex:(NSUInteger)index
+{
+  CALayer *existingTile = _tiles[@(index)];
+  if ((existingTile.contents && ![_staleTiles containsIndex:index]) || [_pendingTiles containsIndex:index]) {
+    return;
+  }
+
+  CALayer *tile = [self _tileLayerAtIndex:index];
+  const CGRect tileRect = [self _rectForTileAtIndex:index];
+  NSObject *drawParameters = _tileDrawParameters;
+  id cachedContents = [self willDisplayTileAsynchronouslyInRect:tileRect withDrawParameters:drawParameters];
+  if (cachedContents) {
+    [_staleTiles removeIndex:index];
+    tile.contents = cachedContents;
+    return;
+  }
+
+  const int32_t displaySentinelValue = _tileDisplaySentinelValue;
+  ck_async_transaction_operation_block_t displayBlock = [[self class] asyncDisplayBlockWithBounds:tileRect
+                                                                                    contentsScale:self.contentsScale
+                                                                                           opaque:self.opaque
+                                                                                  backgroundColor:self.backgroundColor
+                                                                                  displaySentinel:&_displaySentinel
+                                                                     expectedDisplaySentinelValue:displaySentinelValue
+                                                                                  drawingDelegate:(id<CKAsyncLayerDrawingDelegate>)[self class]
+                                                                                   drawParameters:drawParameters];
+  if (_tilesRenderSynchronously) {
+    id contents = displayBlock();
+    [_staleTiles removeIndex:index];
+    if (contents) {
+      [self didDisplayTileAsynchronously:contents inRect:tileRect withDrawParameters:drawParameters];
+    }
+    tile.contents = contents;
+    return;
+  }
+
+  [_pendingTiles addIndex:index];
+  CALayer *containerLayer = self.ck_parentTransactionContainer ?: self;
+  [self _addDisplayBlock:displayBlock
+           toTransaction:containerLayer.ck_asyncTransaction
+           sentinelValue:displaySentinelValue
+              completion:^(id<NSObject> value, BOOL canceled) {
+                CKCAssertMainThread();
+                if (_displaySentinel != displaySentinelValue) {
+                  return;
+                }
+                [_pendingTiles removeIndex:index];
+                if (!canceled && value) {
+                  [_staleTiles removeIndex:index];
+                  [self didDisplayTileAsynchronously:value inRect:tileRect withDrawParameters:drawParameters];
+                  _tiles[@(index)].contents = value;
+                }
+              }];
+}
+
+- (void)_removeAllTiles
+{
+  if (_tiles.count == 0) {
+    return;
+  }
+  for (CALayer *tile in [_tiles allValues]) {
+    [tile removeFromSuperlayer];
+  }
+  [_tiles removeAllObjects];
+  [_pendingTiles removeAllIndexes];
+  [_staleTiles removeAllIndexes];
+  _tileDrawParameters = nil;
+}
+
+- (void)_didReceiveMemoryWarning:(NSNotification *)notification
+{
+  CKAssertMainThread();
+  if (_tiles.count == 0) {
+    return;
+  }
+  const NSRange visibleTiles = [self _visibleTileRange];
+  for (NSNumber *index in [_tiles allKeys]) {
+    if (!NSLocationInRange(index.unsignedIntegerValue, visibleTiles) && ![_pendingTiles containsIndex:index.unsignedIntegerValue]) {
+      [_tiles[index] removeFromSuperlayer];
+      [_tiles removeObjectForKey:index];
+    }
+  }
+}
+
 #pragma mark - Drawing
 
 /// this method exists to provide an override point for ASDisplayNodeAsyncLayer where it can use its asyncDelegate in place
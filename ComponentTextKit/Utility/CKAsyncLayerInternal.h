@@ -22,13 +22,6 @@
   int32_t _displaySentinel;
 }
 
-/**
- @summary The dispatch queue used for async display.
-
- @desc This is exposed here for tests only.
- */
-+ (dispatch_queue_t)displayQueue;
-
 + (ck_async_transaction_operation_block_t)asyncDisplayBlockWithBounds:(CGRect)bounds
                                                         contentsScale:(CGFloat)contentsScale
                                                                opaque:(BOOL)opaque
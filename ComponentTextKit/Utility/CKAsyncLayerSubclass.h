@@ -30,4 +30,19 @@
  */
 - (void)didDisplayAsynchronously:(id)newContents withDrawParameters:(id<NSObject>)drawParameters;
 
+/**
+ The tiled counterpart of -willDisplayAsynchronouslyWithDrawParameters:, called on the main thread before a tile is
+ drawn.
+
+ @param tileRect The rect covered by the tile, with its origin relative to the top-left of the bounds.
+ @return A CGImageRef to use as the tile's contents instead of drawing it, or nil.
+ */
+- (id)willDisplayTileAsynchronouslyInRect:(CGRect)tileRect withDrawParameters:(id<NSObject>)drawParameters;
+
+/**
+ The tiled counterpart of -didDisplayAsynchronously:withDrawParameters:, called on the main thread after a tile has been
+ drawn and just before it is applied to the tile's layer.
+ */
+- (void)didDisplayTileAsynchronously:(id)newContents inRect:(CGRect)tileRect withDrawParameters:(id<NSObject>)drawParameters;
+
 @end
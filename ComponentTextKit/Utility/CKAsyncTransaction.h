@@ -17,6 +17,37 @@ typedef id<NSObject>(^ck_async_transaction_operation_block_t)(void);
 typedef void(^ck_async_transaction_operation_completion_block_t)(id<NSObject> value, BOOL canceled);
 typedef void(^ck_async_transaction_complete_async_operation_block_t)(id<NSObject> value);
 typedef void(^ck_async_transaction_async_operation_block_t)(ck_async_transaction_complete_async_operation_block_t completeOperationBlock);
+/**
+ Completes an operation added with -addScheduledOperationWithBlock:queue:completion:. startTime and endTime are the
+ CACurrentMediaTime() at which the work actually started and ended; they are ignored if canceled is YES, i.e. if the
+ work never ran.
+ */
+typedef void(^ck_async_transaction_complete_scheduled_operation_block_t)(id<NSObject> value, CFTimeInterval startTime, CFTimeInterval endTime, BOOL canceled);
+typedef void(^ck_async_transaction_scheduled_operation_block_t)(ck_async_transaction_complete_scheduled_operation_block_t completeOperationBlock);
+
+/**
+ Timings of a completed transaction. Times are in seconds.
+ */
+typedef struct {
+  /** Operations added to the transaction, including the ones added by -addCompletionBlock:. */
+  NSUInteger operationCount;
+  /** Operations whose execution block was skipped because the transaction had been canceled, or that reported being
+   canceled by whatever scheduled them. */
+  NSUInteger canceledOperationCount;
+  /** Sum over operations of the time between being added and starting to execute. */
+  NSTimeInterval totalQueueWaitTime;
+  /** The longest any single operation waited to start executing. */
+  NSTimeInterval maximumQueueWaitTime;
+  /** Sum over operations of the time spent executing, e.g. drawing. */
+  NSTimeInterval totalExecutionTime;
+  /** Time spent running the operation completion blocks and the transaction completion block on the callback queue. */
+  NSTimeInterval completionTime;
+  /** Whether the transaction was canceled. */
+  BOOL canceled;
+} CKAsyncTransactionMetrics;
+
+typedef void(^ck_async_transaction_metrics_block_t)(CKAsyncTransaction *transaction, CKAsyncTransactionMetrics metrics);
+typedef void(^ck_async_transaction_completion_dispatcher_t)(dispatch_block_t runCompletions);
 
 /**
  State is initially CKAsyncTransactionStateOpen.
@@ -71,6 +102,21 @@ typedef NS_ENUM(NSUInteger, CKAsyncTransactionState) {
  */
 @property (nonatomic, readonly) CKAsyncTransactionState state;
 
+/**
+ Called on callbackQueue with the transaction's timings, right after its completion block. Must be set before commit.
+ */
+@property (nonatomic, copy) ck_async_transaction_metrics_block_t metricsBlock;
+
+/**
+ @summary Lets the owner decide when the completion blocks run.
+
+ @desc When set, the transaction doesn't dispatch its completion blocks to callbackQueue itself once its operations are
+ done. Instead it passes a block that runs them to completionDispatcher, from a background queue, and that block must
+ then be run on callbackQueue. CKAsyncTransactionGroup uses this to run the completions of several transactions in a
+ single callback. Must be set before commit.
+ */
+@property (nonatomic, copy) ck_async_transaction_completion_dispatcher_t completionDispatcher;
+
 /**
  @summary Adds a synchronous operation to the transaction.  The execution block will be executed immediately.
 
@@ -105,6 +151,24 @@ typedef NS_ENUM(NSUInteger, CKAsyncTransactionState) {
                              queue:(dispatch_queue_t)queue
                         completion:(ck_async_transaction_operation_completion_block_t)completion;
 
+/**
+ @summary Adds an operation whose work is handed over to a scheduler of its own, e.g. CKAsyncDisplayScheduler.
+
+ @desc Like -addAsyncOperationWithBlock:queue:completion:, except that the block reports when the work actually started
+ and ended, and whether it was canceled instead, so that the transaction's metrics count the time spent waiting in the
+ scheduler as queue wait rather than execution.
+
+ WARNING: Consumers MUST call the completeOperationBlock passed into the work block, or objects will be leaked!
+
+ @param block The block handing the work over; executed on queue.
+ @param queue The dispatch queue on which to execute the block.
+ @param completion The completion block that will be executed with the output of the work when all of the operations
+ in the transaction are completed. Executed and released on callbackQueue.
+ */
+- (void)addScheduledOperationWithBlock:(ck_async_transaction_scheduled_operation_block_t)block
+                                 queue:(dispatch_queue_t)queue
+                            completion:(ck_async_transaction_operation_completion_block_t)completion;
+
 
 /**
  @summary Adds a block to run on the completion of the async transaction.
@@ -10,12 +10,18 @@
 
 #import <ComponentKit/CKAsyncTransaction.h>
 
+#import <QuartzCore/QuartzCore.h>
+
 #import <ComponentKit/CKAssert.h>
 
 @interface CKAsyncTransactionOperation : NSObject
 - (id)initWithOperationCompletionBlock:(ck_async_transaction_operation_completion_block_t)operationCompletionBlock;
 @property (nonatomic, copy) ck_async_transaction_operation_completion_block_t operationCompletionBlock;
 @property (atomic, retain) id<NSObject> value; // set on bg queue by the operation block
+// Timings for CKAsyncTransactionMetrics. Written before the group is left, so they're visible to the notify block.
+@property (nonatomic, assign) CFTimeInterval addTime;
+@property (nonatomic, assign) CFTimeInterval startTime;
+@property (nonatomic, assign) CFTimeInterval endTime;
 @end
 
 @implementation CKAsyncTransactionOperation
@@ -85,12 +91,43 @@
   [self _ensureTransactionData];
 
   CKAsyncTransactionOperation *operation = [[CKAsyncTransactionOperation alloc] initWithOperationCompletionBlock:completion];
+  operation.addTime = CACurrentMediaTime();
   [_operations addObject:operation];
   dispatch_group_async(_group, queue, ^{
     if (_state != CKAsyncTransactionStateCanceled) {
       dispatch_group_enter(_group);
+      operation.startTime = CACurrentMediaTime();
       block(^(id<NSObject> value){
         operation.value = value;
+        operation.endTime = CACurrentMediaTime();
+        dispatch_group_leave(_group);
+      });
+    }
+  });
+}
+
+- (void)addScheduledOperationWithBlock:(ck_async_transaction_scheduled_operation_block_t)block
+                                 queue:(dispatch_queue_t)queue
+                            completion:(ck_async_transaction_operation_completion_block_t)completion
+{
+  CKAssertMainThread();
+  CKAssert(_state == CKAsyncTransactionStateOpen, @"You can only add operations to open transactions");
+
+  [self _ensureTransactionData];
+
+  CKAsyncTransactionOperation *operation = [[CKAsyncTransactionOperation alloc] initWithOperationCompletionBlock:completion];
+  operation.addTime = CACurrentMediaTime();
+  [_operations addObject:operation];
+  dispatch_group_async(_group, queue, ^{
+    if (_state != CKAsyncTransactionStateCanceled) {
+      dispatch_group_enter(_group);
+      block(^(id<NSObject> value, CFTimeInterval startTime, CFTimeInterval endTime, BOOL canceled){
+        operation.value = value;
+        // Canceled operations keep a zero startTime, which is what the metrics count as canceled.
+        if (!canceled) {
+          operation.startTime = startTime;
+          operation.endTime = endTime;
+        }
         dispatch_group_leave(_group);
       });
     }
@@ -107,10 +144,13 @@
   [self _ensureTransactionData];
 
   CKAsyncTransactionOperation *operation = [[CKAsyncTransactionOperation alloc] initWithOperationCompletionBlock:completion];
+  operation.addTime = CACurrentMediaTime();
   [_operations addObject:operation];
   dispatch_group_async(_group, queue, ^{
     if (_state != CKAsyncTransactionStateCanceled) {
+      operation.startTime = CACurrentMediaTime();
       operation.value = block();
+      operation.endTime = CACurrentMediaTime();
     }
   });
 }
@@ -142,9 +182,13 @@
     if (_completionBlock) {
       _completionBlock(self, NO);
     }
+    if (_metricsBlock) {
+      _metricsBlock(self, (CKAsyncTransactionMetrics){});
+    }
   } else {
     CKAssert(_group != NULL, @"If there are operations, dispatch group should have been created");
-    dispatch_group_notify(_group, _callbackQueue, ^{
+    dispatch_block_t runCompletions = ^{
+      const CFTimeInterval completionStartTime = CACurrentMediaTime();
       BOOL isCanceled = (_state == CKAsyncTransactionStateCanceled);
       for (CKAsyncTransactionOperation *operation in _operations) {
         [operation callAndReleaseCompletionBlock:isCanceled];
@@ -152,8 +196,42 @@
       if (_completionBlock) {
         _completionBlock(self, isCanceled);
       }
-    });
+      if (_metricsBlock) {
+        CKAsyncTransactionMetrics metrics = [self _metricsWithCompletionTime:CACurrentMediaTime() - completionStartTime];
+        metrics.canceled = isCanceled;
+        _metricsBlock(self, metrics);
+      }
+    };
+    ck_async_transaction_completion_dispatcher_t completionDispatcher = _completionDispatcher;
+    if (completionDispatcher) {
+      dispatch_group_notify(_group, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_HIGH, 0), ^{
+        completionDispatcher(runCompletions);
+      });
+    } else {
+      dispatch_group_notify(_group, _callbackQueue, runCompletions);
+    }
+  }
+}
+
+- (CKAsyncTransactionMetrics)_metricsWithCompletionTime:(NSTimeInterval)completionTime
+{
+  CKAsyncTransactionMetrics metrics = {
+    .operationCount = [_operations count],
+    .completionTime = completionTime,
+  };
+  for (CKAsyncTransactionOperation *operation in _operations) {
+    if (operation.startTime == 0) {
+      metrics.canceledOperationCount++;
+      continue;
+    }
+    const NSTimeInterval queueWaitTime = operation.startTime - operation.addTime;
+    metrics.totalQueueWaitTime += queueWaitTime;
+    metrics.maximumQueueWaitTime = MAX(metrics.maximumQueueWaitTime, queueWaitTime);
+    if (operation.endTime > 0) {
+      metrics.totalExecutionTime += operation.endTime - operation.startTime;
+    }
   }
+  return metrics;
 }
 
 #pragma mark - Helper Methods
@@ -0,0 +1,22 @@
+/*
+ *  Copyright (c) 2014-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+
+#import <ComponentKit/CKAsyncTransactionGroup.h>
+
+@interface CKAsyncTransactionGroup ()
+
+/// Runs the queued coalesced completions, then commits the transactions of the added containers. Called by the run
+/// loop observer of the main transaction group on every main run loop iteration.
+- (void)commit;
+
+/// Runs every coalesced completion queued so far, in the order the transactions finished.
+- (void)flushCompletions;
+
+@end
@@ -12,7 +12,20 @@
 
 #import <ComponentKit/CKAsyncTransactionContainer.h>
 
-@class CKAsyncTransaction;
+#import <ComponentKit/CKAsyncTransaction.h>
+
+@class CKAsyncTransactionGroup;
+
+/// Receives the timings of every transaction committed by a group, on the main thread once the transaction completes.
+@protocol CKAsyncTransactionGroupMetricsListener <NSObject>
+
+/// @param containerLayer The layer the transaction belonged to, or nil if it has been deallocated since.
+- (void)transactionGroup:(CKAsyncTransactionGroup *)transactionGroup
+  didCompleteTransaction:(CKAsyncTransaction *)transaction
+             inContainer:(CALayer *)containerLayer
+                 metrics:(CKAsyncTransactionMetrics)metrics;
+
+@end
 
 /// A group of transaction container layers, for which the current transactions are committed together at the end of the next runloop tick.
 @interface CKAsyncTransactionGroup : NSObject
@@ -20,6 +33,15 @@
 /// The main transaction group is scheduled to commit on every tick of the main runloop.
 + (instancetype)mainTransactionGroup;
 
+/// Told about every transaction committed from now on. Weak.
+@property (nonatomic, weak) id<CKAsyncTransactionGroupMetricsListener> metricsListener;
+
+/// When YES, transactions committed from now on don't each dispatch their completions to the main queue. Instead the
+/// group queues them up and runs all the queued completions from its run loop observer, once per main run loop
+/// iteration and before committing the next transactions, so the contents of the transactions that finished since the
+/// last iteration are applied in the same frame. Only the main transaction group has an observer. Defaults to NO.
+@property (nonatomic, assign) BOOL coalescesCompletions;
+
 /// Add a transaction container to be committed.
 /// @param containerLayer A layer containing a transaction to be commited. May or may not be a container layer.
 /// @see CKAsyncTransactionContainer
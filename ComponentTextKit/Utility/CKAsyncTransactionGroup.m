@@ -10,15 +10,22 @@
 
 #import "CKAsyncTransactionGroup.h"
 
+#import <pthread.h>
+
 #import <ComponentKit/CKAssert.h>
 
 #import "CKAsyncTransaction.h"
 #import "CKAsyncTransactionContainer+Private.h"
+#import "CKAsyncTransactionGroup+Private.h"
 
 static void _transactionGroupRunLoopObserverCallback(CFRunLoopObserverRef observer, CFRunLoopActivity activity, void *info);
 
 @implementation CKAsyncTransactionGroup {
   NSHashTable *_containerLayers;
+
+  pthread_mutex_t _completionsMutex;
+  // Guarded by _completionsMutex.
+  NSMutableArray<dispatch_block_t> *_pendingCompletions;
 }
 
 + (CKAsyncTransactionGroup *)mainTransactionGroup
@@ -64,10 +71,17 @@ static void _transactionGroupRunLoopObserverCallback(CFRunLoopObserverRef observ
 {
   if ((self = [super init])) {
     _containerLayers = [[NSHashTable alloc] initWithOptions:NSHashTableStrongMemory|NSHashTableObjectPointerPersonality capacity:0];
+    pthread_mutex_init(&_completionsMutex, NULL);
+    _pendingCompletions = [NSMutableArray array];
   }
   return self;
 }
 
+- (void)dealloc
+{
+  pthread_mutex_destroy(&_completionsMutex);
+}
+
 #pragma mark Public methods
 
 - (void)addTransactionContainer:(CALayer *)containerLayer
@@ -83,6 +97,8 @@ static void _transactionGroupRunLoopObserverCallback(CFRunLoopObserverRef observ
 {
   CKAssertMainThread();
 
+  [self flushCompletions];
+
   if ([_containerLayers count]) {
     NSSet *containerLayersToCommit = [_containerLayers copy];
     [_containerLayers removeAllObjects];
@@ -92,11 +108,68 @@ static void _transactionGroupRunLoopObserverCallback(CFRunLoopObserverRef observ
       // so we must nil out the transaction we're committing first.
       CKAsyncTransaction *transaction = containerLayer.ck_currentAsyncLayerTransaction;
       containerLayer.ck_currentAsyncLayerTransaction = nil;
+      [self _configureTransaction:transaction forContainer:containerLayer];
       [transaction commit];
     }
   }
 }
 
+- (void)_configureTransaction:(CKAsyncTransaction *)transaction forContainer:(CALayer *)containerLayer
+{
+  __weak CKAsyncTransactionGroup *weakSelf = self;
+  if (_metricsListener) {
+    __weak CALayer *weakContainerLayer = containerLayer;
+    transaction.metricsBlock = ^(CKAsyncTransaction *completedTransaction, CKAsyncTransactionMetrics metrics) {
+      CKAsyncTransactionGroup *strongSelf = weakSelf;
+      [strongSelf.metricsListener transactionGroup:strongSelf
+                            didCompleteTransaction:completedTransaction
+                                       inContainer:weakContainerLayer
+                                           metrics:metrics];
+    };
+  }
+  // Container transactions call back on the main queue, and coalesced completions are flushed on the main thread.
+  if (_coalescesCompletions && transaction.callbackQueue == dispatch_get_main_queue()) {
+    // Strongly captured: completions must run even if nothing else holds on to the group.
+    transaction.completionDispatcher = ^(dispatch_block_t runCompletions) {
+      [self _enqueueCompletions:runCompletions];
+    };
+  }
+}
+
+#pragma mark Coalesced completions
+
+- (void)_enqueueCompletions:(dispatch_block_t)runCompletions
+{
+  BOOL wasEmpty;
+  pthread_mutex_lock(&_completionsMutex);
+  wasEmpty = ([_pendingCompletions count] == 0);
+  [_pendingCompletions addObject:runCompletions];
+  pthread_mutex_unlock(&_completionsMutex);
+
+  // The completions are flushed by the run loop observer, which only fires when the main run loop is about to sleep;
+  // wake it up in case it is sleeping already.
+  if (wasEmpty) {
+    CFRunLoopWakeUp(CFRunLoopGetMain());
+  }
+}
+
+- (void)flushCompletions
+{
+  CKAssertMainThread();
+  pthread_mutex_lock(&_completionsMutex);
+  if ([_pendingCompletions count] == 0) {
+    pthread_mutex_unlock(&_completionsMutex);
+    return;
+  }
+  NSArray<dispatch_block_t> *completions = _pendingCompletions;
+  _pendingCompletions = [NSMutableArray array];
+  pthread_mutex_unlock(&_completionsMutex);
+
+  for (dispatch_block_t runCompletions in completions) {
+    runCompletions();
+  }
+}
+
 @end
 
 static void _transactionGroupRunLoopObserverCallback(CFRunLoopObserverRef observer, CFRunLoopActivity activity, void *info)
@@ -0,0 +1,59 @@
+/*
+ *  Copyright (c) 2014-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+
+
+#import <CoreGraphics/CoreGraphics.h>
+#import <Foundation/Foundation.h>
+
+namespace CK {
+  /**
+   Recycles the backing stores of asynchronously displayed bitmaps.
+
+   UIGraphicsBeginImageContextWithOptions allocates and zero-fills a new backing store for every draw, and
+   CGBitmapContextCreateImage then copies it into the image. Contexts created here borrow a buffer of the right pixel
+   size from a pool instead, and images created from them wrap that same buffer through a data provider. Once both the
+   context and the image (e.g. replaced layer contents, or an evicted raster cache entry) are released, the buffer goes
+   back into the pool for the next display of that size. The pool is bounded and emptied on memory warnings.
+   */
+  namespace BitmapBufferPool {
+    /**
+     Creates a bitmap context backed by a pooled buffer, using the same coordinate space as
+     UIGraphicsBeginImageContextWithOptions: the origin is at the top left and one unit is one point.
+
+     @param size The size in points.
+     @param scale The number of pixels per point.
+     @param opaque Whether the bitmap needs an alpha channel.
+     @param clear Whether the bitmap must start out transparent. Pass false when the drawing will cover every pixel, such
+     as an opaque background fill, to skip clearing a recycled buffer.
+     @return A context to release with CGContextRelease, or NULL for an empty size.
+     */
+    CGContextRef createContext(CGSize size, CGFloat scale, bool opaque, bool clear);
+
+    /**
+     Creates an image of the context's current contents without copying them. The context must come from
+     createContext(), and must not be drawn into afterwards.
+     */
+    CGImageRef createImage(CGContextRef context);
+
+    struct Stats {
+      /** Contexts that got a buffer from the pool. */
+      NSUInteger reuses;
+      /** Contexts that had to allocate a new buffer. */
+      NSUInteger allocations;
+      /** Bytes held by idle buffers in the pool. */
+      size_t pooledBytes;
+    };
+
+    Stats stats();
+
+    /** Frees every idle buffer. Buffers in use go back to the allocator instead of the pool when released. */
+    void drain();
+  }
+}
@@ -0,0 +1,229 @@
+/*
+ *  Copyright (c) 2014-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+
+
+#import "CKBitmapBufferPool.h"
+
+#import <atomic>
+#import <new>
+#import <unordered_map>
+#import <vector>
+
+#import <UIKit/UIKit.h>
+
+#import <ComponentKit/CKMutex.h>
+
+namespace CK {
+  namespace BitmapBufferPool {
+    /** Lives just before the pixels of every buffer, so callbacks that are only given the pixels can find it. */
+    struct Header {
+      size_t bytesPerRow;
+      size_t height;
+      /** The context and the image each hold a reference. */
+      std::atomic<int> references;
+    };
+
+    // Keeps the pixels 64 byte aligned, which is what Core Animation prefers for zero-copy contents.
+    static const size_t kHeaderSize = 64;
+    static const size_t kRowAlignment = 64;
+    static const size_t kMaximumPooledBytes = 8 * 1024 * 1024;
+    static const size_t kMaximumBuffersPerSize = 4;
+
+    static CK::StaticMutex __poolMutex = CK_MUTEX_INITIALIZER;
+    // All guarded by __poolMutex. Idle buffers (pointers to their header) keyed by bytesPerRow and height.
+    static std::unordered_map<uint64_t, std::vector<void *>> *__idleBuffers;
+    static Stats __stats;
+
+    static uint64_t keyFor(size_t bytesPerRow, size_t height)
+    {
+      return ((uint64_t)bytesPerRow << 32) | (uint64_t)height;
+    }
+
+    static size_t bufferLength(size_t bytesPerRow, size_t height)
+    {
+      return kHeaderSize + bytesPerRow * height;
+    }
+
+    static Header *headerForData(void *data)
+    {
+      return (Header *)((char *)data - kHeaderSize);
+    }
+
+    static void *dataForHeader(Header *header)
+    {
+      return (char *)header + kHeaderSize;
+    }
+
+    static void ensurePool()
+    {
+      static dispatch_once_t onceToken;
+      dispatch_once(&onceToken, ^{
+        __idleBuffers = new std::unordered_map<uint64_t, std::vector<void *>>();
+        [[NSNotificationCenter defaultCenter] addObserverForName:UIApplicationDidReceiveMemoryWarningNotification
+                                                          object:nil
+                                                           queue:nil
+                                                      usingBlock:^(NSNotification *note) {
+                                                        drain();
+                                                      }];
+      });
+    }
+
+    static Header *takeBuffer(size_t bytesPerRow, size_t height)
+    {
+      ensurePool();
+      {
+        CK::StaticMutexLocker l(__poolMutex);
+        auto it = __idleBuffers->find(keyFor(bytesPerRow, height));
+        if (it != __idleBuffers->end() && !it->second.empty()) {
+          void *buffer = it->second.back();
+          it->second.pop_back();
+          __stats.pooledBytes -= bufferLength(bytesPerRow, height);
+          __stats.reuses++;
+          return (Header *)buffer;
+        }
+        __stats.allocations++;
+      }
+      void *buffer = NULL;
+      if (posix_memalign(&buffer, kHeaderSize, bufferLength(bytesPerRow, height)) != 0) {
+        return NULL;
+      }
+      Header *header = new (buffer) Header();
+      header->bytesPerRow = bytesPerRow;
+      header->height = height;
+      return header;
+    }
+
+    static void releaseBuffer(void *data)
+    {
+      Header *header = headerForData(data);
+      if (--header->references > 0) {
+        return;
+      }
+      const size_t length = bufferLength(header->bytesPerRow, header->height);
+      {
+        CK::StaticMutexLocker l(__poolMutex);
+        std::vector<void *> &buffers = (*__idleBuffers)[keyFor(header->bytesPerRow, header->height)];
+        if (buffers.size() < kMaximumBuffersPerSize && __stats.pooledBytes + length <= kMaximumPooledBytes) {
+          buffers.push_back(header);
+          __stats.pooledBytes += length;
+          return;
+        }
+      }
+      free(header);
+    }
+
+    static void contextReleaseCallback(void *releaseInfo, void *data)
+    {
+      releaseBuffer(data);
+    }
+
+    static void dataProviderReleaseCallback(void *info, const void *data, size_t size)
+    {
+      releaseBuffer((void *)data);
+    }
+
+    static CGColorSpaceRef deviceRGBColorSpace()
+    {
+      static CGColorSpaceRef colorSpace;
+      static dispatch_once_t onceToken;
+      dispatch_once(&onceToken, ^{
+        colorSpace = CGColorSpaceCreateDeviceRGB();
+      });
+      return colorSpace;
+    }
+
+    static CGBitmapInfo bitmapInfo(bool opaque)
+    {
+      // Native 32-bit BGRA, the layout Core Animation can display without converting.
+      return kCGBitmapByteOrder32Little | (opaque ? kCGImageAlphaNoneSkipFirst : kCGImageAlphaPremultipliedFirst);
+    }
+
+    CGContextRef createContext(CGSize size, CGFloat scale, bool opaque, bool clear)
+    {
+      const size_t width = (size_t)ceil(size.width * scale);
+      const size_t height = (size_t)ceil(size.height * scale);
+      if (width == 0 || height == 0) {
+        return NULL;
+      }
+      const size_t bytesPerRow = (width * 4 + kRowAlignment - 1) / kRowAlignment * kRowAlignment;
+      Header *header = takeBuffer(bytesPerRow, height);
+      if (!header) {
+        return NULL;
+      }
+      header->references = 1;
+      void *data = dataForHeader(header);
+      if (clear) {
+        memset(data, 0, bytesPerRow * height);
+      }
+
+      CGContextRef context = CGBitmapContextCreateWithData(data, width, height, 8, bytesPerRow, deviceRGBColorSpace(),
+                                                           bitmapInfo(opaque), &contextReleaseCallback, NULL);
+      if (!context) {
+        releaseBuffer(data);
+        return NULL;
+      }
+      // Flip and scale into UIKit's coordinate space.
+      CGContextTranslateCTM(context, 0, height);
+      CGContextScaleCTM(context, scale, -scale);
+      return context;
+    }
+
+    CGImageRef createImage(CGContextRef context)
+    {
+      void *data = CGBitmapContextGetData(context);
+      Header *header = headerForData(data);
+      const size_t length = header->bytesPerRow * header->height;
+      header->references++;
+      CGDataProviderRef provider = CGDataProviderCreateWithData(NULL, data, length, &dataProviderReleaseCallback);
+      if (!provider) {
+        header->references--;
+        return NULL;
+      }
+      CGImageRef image = CGImageCreate(CGBitmapContextGetWidth(context),
+                                       CGBitmapContextGetHeight(context),
+                                       CGBitmapContextGetBitsPerComponent(context),
+                                       CGBitmapContextGetBitsPerPixel(context),
+                                       header->bytesPerRow,
+                                       CGBitmapContextGetColorSpace(context),
+                                       CGBitmapContextGetBitmapInfo(context),
+                                       provider,
+                                       NULL,
+                                       false,
+                                       kCGRenderingIntentDefault);
+      // The image retains the provider, which hands the buffer back once the image is gone.
+      CGDataProviderRelease(provider);
+      return image;
+    }
+
+    Stats stats()
+    {
+      ensurePool();
+      CK::StaticMutexLocker l(__poolMutex);
+      return __stats;
+    }
+
+    void drain()
+    {
+      ensurePool();
+      std::vector<void *> buffers;
+      {
+        CK::StaticMutexLocker l(__poolMutex);
+        for (auto &entry : *__idleBuffers) {
+          buffers.insert(buffers.end(), entry.second.begin(), entry.second.end());
+        }
+        __idleBuffers->clear();
+        __stats.pooledBytes = 0;
+      }
+      for (void *buffer : buffers) {
+        free(buffer);
+      }
+    }
+  }
+}
@@ -13,8 +13,15 @@
 
 #import <ComponentKit/CKFunctor.h>
 #import <ComponentKit/CKAssert.h>
+#import <ComponentKit/CKMutex.h>
 
 #import <CoreGraphics/CoreGraphics.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iterator>
+#include <memory>
 #include <mutex>
 #include <unordered_map>
 #include <list>
@@ -26,6 +33,50 @@
 
 namespace CK {
 
+  /** Why an item left the cache, as reported by CacheStats and the eviction callback. */
+  enum class CacheEvictionReason {
+    /** Inserting pushed the cache over its maxCost. */
+    capacity,
+    /** An explicit call to compact(). */
+    compaction,
+    /** Compaction in response to a memory warning. */
+    memoryWarning,
+  };
+
+  /**
+   Snapshot of a cache's counters since it was created. Costs are in whatever unit the cache's owner passes to insert().
+   */
+  struct CacheStats {
+    NSUInteger hits = 0;
+    NSUInteger misses = 0;
+    NSUInteger inserts = 0;
+    NSUInteger capacityEvictions = 0;
+    NSUInteger compactionEvictions = 0;
+    NSUInteger memoryWarningEvictions = 0;
+    /** Number of compaction passes of any reason, and the total wall time they took. */
+    NSUInteger compactions = 0;
+    double compactionSeconds = 0;
+    NSUInteger currentCost = 0;
+    NSUInteger peakCost = 0;
+
+    NSUInteger evictions() const { return capacityEvictions + compactionEvictions + memoryWarningEvictions; }
+
+    CacheStats &operator+=(const CacheStats &other)
+    {
+      hits += other.hits;
+      misses += other.misses;
+      inserts += other.inserts;
+      capacityEvictions += other.capacityEvictions;
+      compactionEvictions += other.compactionEvictions;
+      memoryWarningEvictions += other.memoryWarningEvictions;
+      compactions += other.compactions;
+      compactionSeconds += other.compactionSeconds;
+      currentCost += other.currentCost;
+      peakCost += other.peakCost;
+      return *this;
+    }
+  };
+
   /**
    Templated cache class, based on:
    http://aim.adc.rmit.edu.au/phd/sgreuter/papers/graphite2003.pdf
@@ -117,6 +168,12 @@ namespace CK {
 
     typedef typename CacheMapT::allocator_type allocator_type;
 
+    /**
+     Called once for every item removed by compaction, before the item is erased. Invoked synchronously from whichever
+     call triggered the eviction (and so under the lock of a concurrent cache); it must not call back into the cache.
+     */
+    typedef std::function<void(const KeyT &key, const ValueT &value, CacheEvictionReason reason)> EvictionCallback;
+
     hasher hash_funct() const { return _keysToItems.hash_funct(); }
     key_equal key_eq() const { return _keysToItems.key_eq(); }
     allocator_type get_allocator() const { return _keysToItems.get_allocator(); }
@@ -143,6 +200,15 @@ namespace CK {
 
     void setCompactionFactor(CGFloat newFactor) { _compactionFactor = newFactor; }
 
+    void setEvictionCallback(EvictionCallback callback) { _evictionCallback = std::move(callback); }
+
+    CacheStats stats() const
+    {
+      CacheStats stats = _stats;
+      stats.currentCost = getCurrentCost();
+      return stats;
+    }
+
     void removeAllObjects()
     {
       _keysToItems.clear();
@@ -166,27 +232,30 @@ namespace CK {
     }
 
     /** Executes a forced compact based on any given compaction factor. */
-    void compact(CGFloat compactionFactor)
+    void compact(CGFloat compactionFactor, CacheEvictionReason reason = CacheEvictionReason::compaction)
     {
       const CGFloat clampedFactor = std::max(std::min(compactionFactor, (CGFloat)1), (CGFloat)0);
-      _eraseItemsWithCost(ceil((CGFloat)getCurrentCost() * clampedFactor));
+      _eraseItemsWithCost(ceil((CGFloat)getCurrentCost() * clampedFactor), reason);
     }
 
     void insert(const KeyT &key, const ValueT &value, const NSUInteger cost)
     {
       onInsertItem(key, cost);
       _keysToItems[key] = value;
+      _stats.inserts++;
       _compactIfNeeded();
+      // Recorded once the insert has settled, so the peak never exceeds the maximum cost.
+      _stats.peakCost = std::max(_stats.peakCost, getCurrentCost());
     }
 
     ValueT find(const KeyT &first, ValueT notFoundValue, bool touch = true)  // not const, since it modifies _costs
     {
       auto i = _keysToItems.find(first);
       if (i == _keysToItems.end()) {
-        _miss++;
+        _stats.misses++;
         return notFoundValue;
       } else {
-        _hit++;
+        _stats.hits++;
         if (touch) {
           // LRU
           onItemHit(i->first);
@@ -207,6 +276,16 @@ namespace CK {
       return find(first, nil, touch);
     }
 
+    /**
+     Looks up a value without touching the strategy and without updating the hit/miss counters. Since it does not
+     mutate the cache it is safe to call concurrently from several readers. Returns nullptr when the key is missing.
+     */
+    const ValueT *peek(const KeyT &first) const
+    {
+      auto i = _keysToItems.find(first);
+      return i == _keysToItems.end() ? nullptr : &i->second;
+    }
+
   private:
     // identifier of cache
     const std::string _cacheName;
@@ -214,8 +293,8 @@ namespace CK {
     // total costs this cache can hold
     NSUInteger _maxCost;
 
-    NSUInteger _hit = 0;
-    NSUInteger _miss = 0;
+    CacheStats _stats;
+    EvictionCallback _evictionCallback;
 
     CGFloat _compactionFactor;
 
@@ -242,25 +321,48 @@ namespace CK {
       }
 
       const NSUInteger targetCost = floorf((float)_maxCost * (1 - _compactionFactor));
-      _eraseItemsWithCost(currentCost - targetCost);
+      _eraseItemsWithCost(currentCost - targetCost, CacheEvictionReason::capacity);
     }
 
-    void _eraseItemsWithCost(NSUInteger toEraseCost)
+    void _eraseItemsWithCost(NSUInteger toEraseCost, CacheEvictionReason reason)
     {
       if (toEraseCost == 0) {
         return;
       }
 
+      const auto start = std::chrono::steady_clock::now();
       std::vector<KeyT> keysToRemove(std::move(onCompact(toEraseCost)));
       for (const auto &key : keysToRemove) {
+        if (_evictionCallback) {
+          auto i = _keysToItems.find(key);
+          if (i != _keysToItems.end()) {
+            _evictionCallback(i->first, i->second, reason);
+          }
+        }
         _keysToItems.erase(key);
       }
+
+      switch (reason) {
+        case CacheEvictionReason::capacity:
+          _stats.capacityEvictions += keysToRemove.size();
+          break;
+        case CacheEvictionReason::compaction:
+          _stats.compactionEvictions += keysToRemove.size();
+          break;
+        case CacheEvictionReason::memoryWarning:
+          _stats.memoryWarningEvictions += keysToRemove.size();
+          break;
+      }
+      _stats.compactions++;
+      _stats.compactionSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
     }
   };
 
   /**
     Strategies.
 
+    Available: CacheLRUStrategy, CacheL2LRUStrategy and CacheTinyLFUStrategy.
+
     To be used with CacheImpl, they need to fulfill following interface
        void insertItem(const Key &key, const NSUInteger cost);
        void moveItemAfterHit(const Key &key);
@@ -513,6 +615,242 @@ namespace CK {
       return keysRemoved;
     }
   };
+
+  /**
+   FrequencySketch
+
+   Count-min sketch with 4-bit saturating counters used by CacheTinyLFUStrategy to estimate how often a key has been
+   seen recently. After sampleSize increments every counter is halved, so old popularity fades out.
+   */
+  template <typename KeyT, typename HashFunc>
+  class FrequencySketch
+  {
+    static constexpr size_t kDepth = 4;
+    static constexpr uint8_t kMaxCount = 15;
+
+    std::vector<uint8_t> _counters;
+    size_t _widthMask;
+    NSUInteger _sampleSize;
+    NSUInteger _additions = 0;
+    HashFunc _hasher;
+
+    size_t _indexOf(size_t hash, size_t row) const
+    {
+      static const uint64_t seeds[kDepth] = {0xc3a5c85c97cb3127ULL, 0xb492b66fbe98f273ULL, 0x9ae16a3b2f90404fULL, 0xcbf29ce484222325ULL};
+      uint64_t h = (hash + seeds[row]) * seeds[(row + 1) % kDepth];
+      h ^= h >> 32;
+      return row * (_widthMask + 1) + (h & _widthMask);
+    }
+
+    void _age()
+    {
+      for (auto &counter : _counters) {
+        counter >>= 1;
+      }
+      _additions /= 2;
+    }
+
+  public:
+    /** width is rounded up to a power of two; it should be on the order of the number of distinct hot keys. */
+    FrequencySketch(size_t width)
+    {
+      size_t w = 16;
+      while (w < width) {
+        w <<= 1;
+      }
+      _widthMask = w - 1;
+      _counters.assign(kDepth * w, 0);
+      _sampleSize = 10 * w;
+    }
+
+    void increment(const KeyT &key)
+    {
+      const size_t hash = _hasher(key);
+      bool added = false;
+      for (size_t row = 0; row < kDepth; row++) {
+        uint8_t &counter = _counters[_indexOf(hash, row)];
+        if (counter < kMaxCount) {
+          counter++;
+          added = true;
+        }
+      }
+      if (added && ++_additions >= _sampleSize) {
+        _age();
+      }
+    }
+
+    uint8_t frequency(const KeyT &key) const
+    {
+      const size_t hash = _hasher(key);
+      uint8_t minimum = kMaxCount;
+      for (size_t row = 0; row < kDepth; row++) {
+        minimum = std::min(minimum, _counters[_indexOf(hash, row)]);
+      }
+      return minimum;
+    }
+
+    void clear()
+    {
+      std::fill(_counters.begin(), _counters.end(), 0);
+      _additions = 0;
+    }
+  };
+
+  /**
+   CacheTinyLFUStrategy
+
+   W-TinyLFU: frequency based admission in front of an LRU. New items enter a small LRU window. Items falling out of
+   the window become candidates for the main LRU; when the cache has to shed cost, the oldest candidate is compared to
+   the main LRU victim using a FrequencySketch of recent inserts and hits, and whichever was seen less often is evicted.
+   A burst of one-off keys therefore evicts itself instead of flushing frequently reused entries like short labels.
+
+   windowCostLimit should be around 1% of the cache's maxCost (the window absorbs short bursts of recency); the sketch
+   width should be on the order of the number of items the cache holds.
+   */
+  template <typename KeyT, typename ValueT, typename HashFunc=HashFunctor<KeyT>, typename EqFunc=EqualFunctor<KeyT>>
+  class CacheTinyLFUStrategy
+  {
+    //! Types
+    enum class Segment { window, candidates, main };
+    struct Entry {
+      KeyT key;
+      NSUInteger cost;
+      Segment segment;
+    };
+    typedef std::list<Entry> LRUQueue;
+    typedef std::unordered_map<KeyT, typename LRUQueue::iterator, HashFunc, EqFunc> Indexer;
+
+    LRUQueue _window;
+    LRUQueue _candidates;
+    LRUQueue _main;
+    Indexer _keysToEntries;
+    FrequencySketch<KeyT, HashFunc> _sketch;
+
+    const NSUInteger _windowCostLimit;
+    NSUInteger _windowCost = 0;
+    NSUInteger _currentCost = 0;
+
+    LRUQueue &_queue(Segment segment)
+    {
+      if (segment == Segment::window) {
+        return _window;
+      } else if (segment == Segment::candidates) {
+        return _candidates;
+      }
+      return _main;
+    }
+
+    void _moveToFront(typename LRUQueue::iterator it, Segment segment)
+    {
+      if (it->segment == Segment::window) {
+        _windowCost -= it->cost;
+      }
+      if (segment == Segment::window) {
+        _windowCost += it->cost;
+      }
+      LRUQueue &from = _queue(it->segment);
+      it->segment = segment;
+      _queue(segment).splice(_queue(segment).begin(), from, it);
+    }
+
+    void _evict(typename LRUQueue::iterator it, std::vector<KeyT> &keysRemoved, NSInteger &toErase)
+    {
+      toErase -= it->cost;
+      keysRemoved.push_back(it->key);
+      _removeEntry(it);
+    }
+
+    void _removeEntry(typename LRUQueue::iterator it)
+    {
+      if (it->segment == Segment::window) {
+        _windowCost -= it->cost;
+      }
+      _currentCost -= it->cost;
+      _keysToEntries.erase(it->key);
+      _queue(it->segment).erase(it);
+    }
+
+  public:
+    CacheTinyLFUStrategy(NSUInteger windowCostLimit = 1, size_t sketchWidth = 1024)
+    : _sketch(sketchWidth), _windowCostLimit(windowCostLimit) {}
+
+    NSUInteger getCurrentCost() const { return _currentCost; }
+
+    void clear()
+    {
+      _window.clear();
+      _candidates.clear();
+      _main.clear();
+      _keysToEntries.clear();
+      _sketch.clear();
+      _windowCost = 0;
+      _currentCost = 0;
+    }
+
+    void insertItem(const KeyT &key, const NSUInteger cost)
+    {
+      _sketch.increment(key);
+      auto it = _keysToEntries.find(key);
+      if (it != _keysToEntries.end()) {
+        _removeEntry(it->second);
+      }
+      _window.push_front({key, cost, Segment::window});
+      _keysToEntries[key] = _window.begin();
+      _windowCost += cost;
+      _currentCost += cost;
+
+      // Overflowing window items queue up for admission, the decision is taken when the cache needs to compact.
+      while (_windowCost > _windowCostLimit && _window.size() > 1) {
+        _moveToFront(std::prev(_window.end()), Segment::candidates);
+      }
+    }
+
+    void moveItemAfterHit(const KeyT &key)
+    {
+      auto it = _keysToEntries.find(key);
+      if (it == _keysToEntries.end()) {
+        return;
+      }
+      _sketch.increment(key);
+      // A hit on a candidate is proof enough of its value, admit it straight away.
+      _moveToFront(it->second, it->second->segment == Segment::window ? Segment::window : Segment::main);
+    }
+
+    void removeItem(const KeyT &key)
+    {
+      auto it = _keysToEntries.find(key);
+      if (it != _keysToEntries.end()) {
+        _removeEntry(it->second);
+      }
+    }
+
+    std::vector<KeyT> compactWithCost(const NSUInteger costToErase)
+    {
+      std::vector<KeyT> keysRemoved;
+      NSInteger toErase = costToErase;
+
+      while (toErase > 0 && _currentCost > 0) {
+        if (!_candidates.empty() && !_main.empty()) {
+          auto candidate = std::prev(_candidates.end());
+          auto victim = std::prev(_main.end());
+          if (_sketch.frequency(candidate->key) > _sketch.frequency(victim->key)) {
+            _evict(victim, keysRemoved, toErase);
+            _moveToFront(candidate, Segment::main);
+          } else {
+            _evict(candidate, keysRemoved, toErase);
+          }
+        } else if (!_candidates.empty()) {
+          _evict(std::prev(_candidates.end()), keysRemoved, toErase);
+        } else if (!_main.empty()) {
+          _evict(std::prev(_main.end()), keysRemoved, toErase);
+        } else {
+          _evict(std::prev(_window.end()), keysRemoved, toErase);
+        }
+      }
+      return keysRemoved;
+    }
+  };
+
   /**
    Concrete Cache (with Strategy)
   */
@@ -574,10 +912,22 @@ namespace CK {
 
     /** Executes a forced compact based on any given compaction factor. */
 
-    void compact(CGFloat compactionFactor)
+    void compact(CGFloat compactionFactor, CacheEvictionReason reason = CacheEvictionReason::compaction)
+    {
+      std::lock_guard<lockPolicy> lg(_l);
+      _cacheImpl.compact(compactionFactor, reason);
+    }
+
+    CacheStats stats()
+    {
+      std::lock_guard<lockPolicy> lg(_l);
+      return _cacheImpl.stats();
+    }
+
+    void setEvictionCallback(typename Cache<KeyT, ValueT, Hasher, KeyEqual>::EvictionCallback callback)
     {
       std::lock_guard<lockPolicy> lg(_l);
-      _cacheImpl.compact(compactionFactor);
+      _cacheImpl.setEvictionCallback(std::move(callback));
     }
 
     void insert(const KeyT &key, const ValueT &value, const NSUInteger cost)
@@ -612,6 +962,173 @@ namespace CK {
     {
     }
   };
+
+  /**
+   ShardedConcurrentCacheImpl
+
+   Same interface as ConcurrentCacheImpl, but the key space is split by Hasher into ShardCount independent caches, each
+   with its own lock, strategy and 1/ShardCount of maxCost. Lookups of keys living in different shards never contend,
+   so caches hit from several layout threads at once scale with the number of cores. Eviction is LRU per shard, which
+   is a close approximation of a global LRU for well distributed hashes.
+
+   Every limit applies per shard: an insert that takes its shard over maxCost/ShardCount compacts that shard alone, even
+   if the others are nearly empty. An item costing more than maxCost/ShardCount empties its whole shard, itself
+   included, as soon as it is inserted, and one costing a sizeable part of it evicts most of its shard. Size maxCost so that the largest items you expect
+   fit comfortably in one shard.
+
+   A touching find() needs exclusive access to its shard because it reorders the strategy queue. To relieve hot
+   shards, setTouchSampleRate(n) only touches one in every n lookups; the remaining lookups run under a shared lock and
+   proceed in parallel. With the default rate of 1 every lookup touches, exactly like ConcurrentCacheImpl.
+   */
+  template <typename KeyT,
+  typename ValueT,
+  typename Hasher=HashFunctor<KeyT>,
+  typename KeyEqual=EqualFunctor<KeyT>,
+  template <typename, typename, typename, typename> class CacheStrategy = CacheLRUStrategy,
+  class lockPolicy = CK::RWMutex,
+  size_t ShardCount = 8>
+  class ShardedConcurrentCacheImpl
+  {
+    static_assert(ShardCount > 0, "ShardedConcurrentCacheImpl needs at least one shard");
+
+  private:
+    struct Shard {
+      CacheImpl<KeyT, ValueT, Hasher, KeyEqual, CacheStrategy> cacheImpl;
+      lockPolicy l;
+      std::atomic<NSUInteger> lookups {0};
+      // Lookups served under the shared lock bypass cacheImpl's counters, so they are tallied here.
+      std::atomic<NSUInteger> sharedHits {0};
+      std::atomic<NSUInteger> sharedMisses {0};
+
+      template <typename ...StrategyArgs>
+      Shard(const std::string &cacheName, NSUInteger maxCost, CGFloat compactionFactor, const StrategyArgs&... args)
+      : cacheImpl(cacheName, maxCost, compactionFactor, args...) {}
+    };
+
+    std::unique_ptr<Shard> _shards[ShardCount];
+    Hasher _hasher;
+    std::atomic<NSUInteger> _touchSampleRate {1};
+
+    Shard &_shardForKey(const KeyT &key)
+    {
+      size_t h = _hasher(key);
+      // Fold the high bits in; many of our hashes are combined with shifts and have weak low bits.
+      h ^= (h >> 16);
+      return *_shards[h % ShardCount];
+    }
+
+    bool _shouldTouch(Shard &shard, bool touch)
+    {
+      if (!touch) {
+        return false;
+      }
+      const NSUInteger rate = _touchSampleRate.load(std::memory_order_relaxed);
+      return rate <= 1 || (shard.lookups.fetch_add(1, std::memory_order_relaxed) % rate) == 0;
+    }
+
+  public:
+    template <typename ...StrategyArgs>
+    ShardedConcurrentCacheImpl(const std::string &cacheName, NSUInteger maxCost, CGFloat compactionFactor, const StrategyArgs&... args)
+    {
+      // The shard budgets add up to maxCost, unless it is smaller than ShardCount since a shard budget of 0 would mean
+      // unlimited. A maxCost of 0 means unlimited, keep it that way for each shard.
+      for (size_t i = 0; i < ShardCount; i++) {
+        const NSUInteger shardMaxCost =
+        std::max(maxCost / ShardCount + (i < maxCost % ShardCount ? 1 : 0), (NSUInteger)(maxCost > 0 ? 1 : 0));
+        _shards[i].reset(new Shard(cacheName, shardMaxCost, compactionFactor, args...));
+      }
+    }
+
+    /** Only one in every rate hits will update the eviction order. Values of 0 and 1 touch on every hit. */
+    void setTouchSampleRate(NSUInteger rate)
+    {
+      _touchSampleRate.store(rate, std::memory_order_relaxed);
+    }
+
+    void compact()
+    {
+      for (auto &shard : _shards) {
+        std::lock_guard<lockPolicy> lg(shard->l);
+        shard->cacheImpl.compact();
+      }
+    }
+
+    /** Executes a forced compact based on any given compaction factor. */
+    void compact(CGFloat compactionFactor, CacheEvictionReason reason = CacheEvictionReason::compaction)
+    {
+      for (auto &shard : _shards) {
+        std::lock_guard<lockPolicy> lg(shard->l);
+        shard->cacheImpl.compact(compactionFactor, reason);
+      }
+    }
+
+    /**
+     Sum of the per-shard stats. Shards peak independently, so peakCost is an upper bound on the true peak of the
+     whole cache. Like the shard budgets, it adds up to at most maxCost.
+     */
+    CacheStats stats()
+    {
+      CacheStats stats;
+      for (auto &shard : _shards) {
+        std::lock_guard<lockPolicy> lg(shard->l);
+        stats += shard->cacheImpl.stats();
+        stats.hits += shard->sharedHits.load(std::memory_order_relaxed);
+        stats.misses += shard->sharedMisses.load(std::memory_order_relaxed);
+      }
+      return stats;
+    }
+
+    void setEvictionCallback(typename Cache<KeyT, ValueT, Hasher, KeyEqual>::EvictionCallback callback)
+    {
+      for (auto &shard : _shards) {
+        std::lock_guard<lockPolicy> lg(shard->l);
+        shard->cacheImpl.setEvictionCallback(callback);
+      }
+    }
+
+    void insert(const KeyT &key, const ValueT &value, const NSUInteger cost)
+    {
+      Shard &shard = _shardForKey(key);
+      std::lock_guard<lockPolicy> lg(shard.l);
+      shard.cacheImpl.insert(key, value, cost);
+    }
+
+    ValueT find(const KeyT &first, ValueT notFoundValue, bool touch = true)
+    {
+      Shard &shard = _shardForKey(first);
+      if (_shouldTouch(shard, touch)) {
+        std::lock_guard<lockPolicy> lg(shard.l);
+        return shard.cacheImpl.find(first, notFoundValue, true);
+      } else {
+        SharedLocker<lockPolicy> sl(shard.l);
+        if (const ValueT *value = shard.cacheImpl.peek(first)) {
+          shard.sharedHits.fetch_add(1, std::memory_order_relaxed);
+          return *value;
+        }
+        shard.sharedMisses.fetch_add(1, std::memory_order_relaxed);
+        return notFoundValue;
+      }
+    }
+
+    template<
+    typename... Dummy,
+    typename U = ValueT,
+    typename = typename std::enable_if<std::is_pointer<U>::value, void>::type
+    >
+    ValueT find(const KeyT &first, bool touch = true)
+    {
+      static_assert(sizeof...(Dummy)==0, "Do not specify template arguments!");
+      return find(first, nil, touch);
+    }
+
+    void removeAllObjects()
+    {
+      for (auto &shard : _shards) {
+        std::lock_guard<lockPolicy> lg(shard->l);
+        shard->cacheImpl.removeAllObjects();
+      }
+    }
+  };
 };// end namespace CK
 
 
@@ -0,0 +1,196 @@
+/*
+ *  Copyright (c) 2014-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+
+
+#import <utility>
+
+#import <XCTest/XCTest.h>
+
+#import <ComponentKit/CKAsyncDisplayScheduler.h>
+#import <ComponentKit/CKAsyncTransaction.h>
+
+@interface CKAsyncDisplaySchedulerTests : XCTestCase
+@end
+
+@implementation CKAsyncDisplaySchedulerTests
+
+- (void)testRunsMoreUrgentLanesFirstAndNewestFirstWithinALane
+{
+  CKAsyncDisplayScheduler *scheduler = [[CKAsyncDisplayScheduler alloc] initWithMaximumConcurrentOperations:1];
+  dispatch_semaphore_t workerStarted = dispatch_semaphore_create(0);
+  dispatch_semaphore_t blockWorker = dispatch_semaphore_create(0);
+  dispatch_group_t group = dispatch_group_create();
+  NSMutableArray<NSString *> *order = [NSMutableArray array];
+
+  // Keeps the only worker busy while everything else is queued.
+  dispatch_group_enter(group);
+  [scheduler scheduleBlock:^{
+    dispatch_semaphore_signal(workerStarted);
+    dispatch_semaphore_wait(blockWorker, DISPATCH_TIME_FOREVER);
+    dispatch_group_leave(group);
+  } cancellation:nil priority:CKAsyncDisplayPriorityVisible displaySentinel:NULL expectedDisplaySentinelValue:0];
+  dispatch_semaphore_wait(workerStarted, DISPATCH_TIME_FOREVER);
+
+  const std::pair<NSString *, CKAsyncDisplayPriority> operations[] = {
+    {@"prefetch", CKAsyncDisplayPriorityPrefetch},
+    {@"visible1", CKAsyncDisplayPriorityVisible},
+    {@"near", CKAsyncDisplayPriorityNearVisible},
+    {@"visible2", CKAsyncDisplayPriorityVisible},
+  };
+  for (const auto &operation : operations) {
+    NSString *name = operation.first;
+    dispatch_group_enter(group);
+    [scheduler scheduleBlock:^{
+      [order addObject:name];
+      dispatch_group_leave(group);
+    } cancellation:nil priority:operation.second displaySentinel:NULL expectedDisplaySentinelValue:0];
+  }
+
+  dispatch_semaphore_signal(blockWorker);
+  XCTAssertEqual(dispatch_group_wait(group, dispatch_time(DISPATCH_TIME_NOW, 5 * NSEC_PER_SEC)), 0);
+  XCTAssertEqualObjects(order, (@[@"visible2", @"visible1", @"near", @"prefetch"]));
+}
+
+- (void)testCancelledOperationsRunTheirCancellationInsteadOfTheirBlock
+{
+  CKAsyncDisplayScheduler *scheduler = [[CKAsyncDisplayScheduler alloc] initWithMaximumConcurrentOperations:1];
+  dispatch_semaphore_t workerStarted = dispatch_semaphore_create(0);
+  dispatch_semaphore_t blockWorker = dispatch_semaphore_create(0);
+  dispatch_group_t group = dispatch_group_create();
+  __block int32_t displaySentinel = 0;
+  __block BOOL ranBlock = NO;
+  __block BOOL ranCancellation = NO;
+
+  dispatch_group_enter(group);
+  [scheduler scheduleBlock:^{
+    dispatch_semaphore_signal(workerStarted);
+    dispatch_semaphore_wait(blockWorker, DISPATCH_TIME_FOREVER);
+    dispatch_group_leave(group);
+  } cancellation:nil priority:CKAsyncDisplayPriorityVisible displaySentinel:NULL expectedDisplaySentinelValue:0];
+  dispatch_semaphore_wait(workerStarted, DISPATCH_TIME_FOREVER);
+
+  dispatch_group_enter(group);
+  [scheduler scheduleBlock:^{
+    ranBlock = YES;
+    dispatch_group_leave(group);
+  } cancellation:^{
+    ranCancellation = YES;
+    dispatch_group_leave(group);
+  } priority:CKAsyncDisplayPriorityVisible displaySentinel:&displaySentinel expectedDisplaySentinelValue:0];
+
+  displaySentinel++;
+  [scheduler cancelOperationsWithDisplaySentinel:&displaySentinel];
+  // Removed from the queue right away, before the worker gets to it.
+  XCTAssertTrue(ranCancellation);
+
+  dispatch_semaphore_signal(blockWorker);
+  XCTAssertEqual(dispatch_group_wait(group, dispatch_time(DISPATCH_TIME_NOW, 5 * NSEC_PER_SEC)), 0);
+  XCTAssertFalse(ranBlock);
+}
+
+- (void)testCancellingOnlyAffectsStaleOperationsOfThatSentinel
+{
+  CKAsyncDisplayScheduler *scheduler = [[CKAsyncDisplayScheduler alloc] initWithMaximumConcurrentOperations:1];
+  dispatch_semaphore_t workerStarted = dispatch_semaphore_create(0);
+  dispatch_semaphore_t blockWorker = dispatch_semaphore_create(0);
+  dispatch_group_t group = dispatch_group_create();
+  __block int32_t displaySentinel = 0;
+  __block int32_t otherDisplaySentinel = 0;
+  NSMutableArray<NSString *> *ran = [NSMutableArray array];
+  NSMutableArray<NSString *> *cancelled = [NSMutableArray array];
+
+  dispatch_group_enter(group);
+  [scheduler scheduleBlock:^{
+    dispatch_semaphore_signal(workerStarted);
+    dispatch_semaphore_wait(blockWorker, DISPATCH_TIME_FOREVER);
+    dispatch_group_leave(group);
+  } cancellation:nil priority:CKAsyncDisplayPriorityVisible displaySentinel:NULL expectedDisplaySentinelValue:0];
+  dispatch_semaphore_wait(workerStarted, DISPATCH_TIME_FOREVER);
+
+  void (^schedule)(NSString *, int32_t *, int32_t) = ^(NSString *name, int32_t *sentinel, int32_t expectedValue) {
+    dispatch_group_enter(group);
+    [scheduler scheduleBlock:^{
+      @synchronized (ran) {
+        [ran addObject:name];
+      }
+      dispatch_group_leave(group);
+    } cancellation:^{
+      @synchronized (cancelled) {
+        [cancelled addObject:name];
+      }
+      dispatch_group_leave(group);
+    } priority:CKAsyncDisplayPriorityVisible displaySentinel:sentinel expectedDisplaySentinelValue:expectedValue];
+  };
+  schedule(@"stale", &displaySentinel, 0);
+  schedule(@"other", &otherDisplaySentinel, 0);
+  displaySentinel++;
+  schedule(@"current", &displaySentinel, 1);
+
+  [scheduler cancelOperationsWithDisplaySentinel:&displaySentinel];
+  XCTAssertEqualObjects(cancelled, (@[@"stale"]));
+
+  dispatch_semaphore_signal(blockWorker);
+  XCTAssertEqual(dispatch_group_wait(group, dispatch_time(DISPATCH_TIME_NOW, 5 * NSEC_PER_SEC)), 0);
+  XCTAssertEqualObjects(ran, (@[@"current", @"other"]));
+  XCTAssertEqualObjects(cancelled, (@[@"stale"]));
+}
+
+- (void)testTransactionMetricsCountTimeInLanesAsQueueWaitAndCountCancelledDisplays
+{
+  CKAsyncDisplayScheduler *scheduler = [[CKAsyncDisplayScheduler alloc] initWithMaximumConcurrentOperations:1];
+  dispatch_semaphore_t workerStarted = dispatch_semaphore_create(0);
+  dispatch_semaphore_t blockWorker = dispatch_semaphore_create(0);
+  [scheduler scheduleBlock:^{
+    dispatch_semaphore_signal(workerStarted);
+    dispatch_semaphore_wait(blockWorker, DISPATCH_TIME_FOREVER);
+  } cancellation:nil priority:CKAsyncDisplayPriorityVisible displaySentinel:NULL expectedDisplaySentinelValue:0];
+  dispatch_semaphore_wait(workerStarted, DISPATCH_TIME_FOREVER);
+
+  // Displays are added the way CKAsyncLayer adds them.
+  __block int32_t displaySentinel = 0;
+  __block int32_t staleDisplaySentinel = 0;
+  __block CKAsyncTransactionMetrics metrics = {};
+  XCTestExpectation *completed = [self expectationWithDescription:@"Transaction completed"];
+  CKAsyncTransaction *transaction = [[CKAsyncTransaction alloc] initWithCallbackQueue:dispatch_get_main_queue()
+                                                                      completionBlock:nil];
+  transaction.metricsBlock = ^(CKAsyncTransaction *completedTransaction, CKAsyncTransactionMetrics transactionMetrics) {
+    metrics = transactionMetrics;
+    [completed fulfill];
+  };
+  [transaction addScheduledOperationWithBlock:[scheduler transactionOperationWithBlock:^id{ return @"drawn"; }
+                                                                              priority:CKAsyncDisplayPriorityVisible
+                                                                       displaySentinel:&displaySentinel
+                                                          expectedDisplaySentinelValue:0]
+                                        queue:scheduler.transactionQueue
+                                   completion:nil];
+  [transaction addScheduledOperationWithBlock:[scheduler transactionOperationWithBlock:^id{ return @"stale"; }
+                                                                              priority:CKAsyncDisplayPriorityVisible
+                                                                       displaySentinel:&staleDisplaySentinel
+                                                          expectedDisplaySentinelValue:0]
+                                        queue:scheduler.transactionQueue
+                                   completion:nil];
+  [transaction commit];
+  // Wait for both operations to be in a lane, then cancel one like -[CKAsyncLayer cancelAsyncDisplay] does.
+  dispatch_sync(scheduler.transactionQueue, ^{});
+  staleDisplaySentinel++;
+  [scheduler cancelOperationsWithDisplaySentinel:&staleDisplaySentinel];
+
+  const NSTimeInterval blockedTime = 0.05;
+  [NSThread sleepForTimeInterval:blockedTime];
+  dispatch_semaphore_signal(blockWorker);
+  [self waitForExpectationsWithTimeout:5 handler:nil];
+
+  XCTAssertEqual(metrics.operationCount, 2u);
+  XCTAssertEqual(metrics.canceledOperationCount, 1u);
+  XCTAssertGreaterThanOrEqual(metrics.maximumQueueWaitTime, blockedTime);
+  XCTAssertLessThan(metrics.totalExecutionTime, blockedTime);
+}
+
+@end
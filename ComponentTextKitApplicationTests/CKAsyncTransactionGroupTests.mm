@@ -0,0 +1,99 @@
+/*
+ *  Copyright (c) 2014-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+
+#import <XCTest/XCTest.h>
+
+#import <QuartzCore/QuartzCore.h>
+
+#import <ComponentKit/CKAsyncTransaction.h>
+#import <ComponentKit/CKAsyncTransactionContainer+Private.h>
+#import <ComponentKit/CKAsyncTransactionGroup.h>
+#import <ComponentKit/CKAsyncTransactionGroup+Private.h>
+
+@interface CKAsyncTransactionGroupTests : XCTestCase <CKAsyncTransactionGroupMetricsListener>
+@end
+
+@implementation CKAsyncTransactionGroupTests
+{
+  XCTestExpectation *_metricsReceived;
+  CKAsyncTransaction *_completedTransaction;
+  CALayer *_completedContainerLayer;
+  CKAsyncTransactionMetrics _metrics;
+}
+
+static CKAsyncTransaction *addTransaction(CKAsyncTransactionGroup *group, CALayer *containerLayer, dispatch_group_t executed, ck_async_transaction_completion_block_t completion)
+{
+  CKAsyncTransaction *transaction = [[CKAsyncTransaction alloc] initWithCallbackQueue:dispatch_get_main_queue()
+                                                                      completionBlock:completion];
+  dispatch_group_enter(executed);
+  [transaction addOperationWithBlock:^id{
+    dispatch_group_leave(executed);
+    return nil;
+  } queue:dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0) completion:nil];
+  containerLayer.ck_currentAsyncLayerTransaction = transaction;
+  [group addTransactionContainer:containerLayer];
+  return transaction;
+}
+
+- (void)testCoalescedCompletionsOfTransactionsFinishingTogetherRunInASingleFlush
+{
+  CKAsyncTransactionGroup *group = [[CKAsyncTransactionGroup alloc] init];
+  group.coalescesCompletions = YES;
+  dispatch_group_t executed = dispatch_group_create();
+  NSMutableArray<CKAsyncTransaction *> *completedTransactions = [NSMutableArray array];
+  for (NSUInteger i = 0; i < 3; i++) {
+    addTransaction(group, [CALayer layer], executed, ^(CKAsyncTransaction *transaction, BOOL canceled) {
+      [completedTransactions addObject:transaction];
+    });
+  }
+  [group commit];
+  XCTAssertEqual(dispatch_group_wait(executed, dispatch_time(DISPATCH_TIME_NOW, 5 * NSEC_PER_SEC)), 0);
+  // Let the transactions hand their completions to the group.
+  [NSThread sleepForTimeInterval:0.1];
+
+  // Nothing is dispatched to the main queue per transaction; this group has no run loop observer to flush them.
+  [[NSRunLoop mainRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.1]];
+  XCTAssertEqual([completedTransactions count], 0u);
+
+  [group flushCompletions];
+  XCTAssertEqual([completedTransactions count], 3u);
+}
+
+- (void)testMetricsListenerReceivesTheMetricsOfCommittedTransactions
+{
+  CKAsyncTransactionGroup *group = [[CKAsyncTransactionGroup alloc] init];
+  group.metricsListener = self;
+  _metricsReceived = [self expectationWithDescription:@"Metrics received"];
+  CALayer *containerLayer = [CALayer layer];
+  CKAsyncTransaction *transaction = addTransaction(group, containerLayer, dispatch_group_create(), nil);
+  [group commit];
+  [self waitForExpectationsWithTimeout:5 handler:nil];
+
+  XCTAssertEqual(_completedTransaction, transaction);
+  XCTAssertEqual(_completedContainerLayer, containerLayer);
+  XCTAssertEqual(_metrics.operationCount, 1u);
+  XCTAssertEqual(_metrics.canceledOperationCount, 0u);
+  XCTAssertFalse(_metrics.canceled);
+}
+
+#pragma mark - CKAsyncTransactionGroupMetricsListener
+
+- (void)transactionGroup:(CKAsyncTransactionGroup *)transactionGroup
+  didCompleteTransaction:(CKAsyncTransaction *)transaction
+             inContainer:(CALayer *)containerLayer
+                 metrics:(CKAsyncTransactionMetrics)metrics
+{
+  _completedTransaction = transaction;
+  _completedContainerLayer = containerLayer;
+  _metrics = metrics;
+  [_metricsReceived fulfill];
+}
+
+@end
@@ -0,0 +1,68 @@
+/*
+ *  Copyright (c) 2014-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+
+
+#import <XCTest/XCTest.h>
+
+#import <UIKit/UIKit.h>
+
+#import <ComponentKit/CKBitmapBufferPool.h>
+
+@interface CKBitmapBufferPoolTests : XCTestCase
+@end
+
+@implementation CKBitmapBufferPoolTests
+
+- (void)setUp
+{
+  [super setUp];
+  CK::BitmapBufferPool::drain();
+}
+
+- (void)testImagesShareTheContextBufferInUIKitCoordinates
+{
+  CGContextRef context = CK::BitmapBufferPool::createContext({2, 2}, 1, false, true);
+  CGContextSetFillColorWithColor(context, [UIColor redColor].CGColor);
+  CGContextFillRect(context, {{0, 0}, {1, 1}});
+  CGImageRef image = CK::BitmapBufferPool::createImage(context);
+  CGContextRelease(context);
+
+  NSData *pixels = CFBridgingRelease(CGDataProviderCopyData(CGImageGetDataProvider(image)));
+  const uint8_t *bytes = (const uint8_t *)pixels.bytes;
+  // Top left pixel is the first in memory, stored as BGRA.
+  XCTAssertEqual(bytes[0], 0);
+  XCTAssertEqual(bytes[2], 255);
+  XCTAssertEqual(bytes[3], 255);
+  // Everything else was cleared.
+  XCTAssertEqual(bytes[7], 0);
+  CGImageRelease(image);
+}
+
+- (void)testBuffersAreRecycledOnceTheImageIsReleased
+{
+  const CK::BitmapBufferPool::Stats initialStats = CK::BitmapBufferPool::stats();
+
+  CGContextRef context = CK::BitmapBufferPool::createContext({100, 50}, 2, true, false);
+  CGImageRef image = CK::BitmapBufferPool::createImage(context);
+  CGContextRelease(context);
+  // Still in use by the image.
+  XCTAssertEqual(CK::BitmapBufferPool::stats().pooledBytes, 0u);
+  CGImageRelease(image);
+  XCTAssertGreaterThan(CK::BitmapBufferPool::stats().pooledBytes, 0u);
+
+  CGContextRef reusedContext = CK::BitmapBufferPool::createContext({100, 50}, 2, true, false);
+  const CK::BitmapBufferPool::Stats stats = CK::BitmapBufferPool::stats();
+  XCTAssertEqual(stats.allocations - initialStats.allocations, 1u);
+  XCTAssertEqual(stats.reuses - initialStats.reuses, 1u);
+  XCTAssertEqual(stats.pooledBytes, 0u);
+  CGContextRelease(reusedContext);
+}
+
+@end
@@ -0,0 +1,262 @@
+/*
+ *  Copyright (c) 2014-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+
+#import <string>
+#import <vector>
+
+#import <XCTest/XCTest.h>
+
+#import <ComponentKit/CKCacheImpl.h>
+
+typedef CK::ShardedConcurrentCacheImpl<int, std::string> ShardedCache;
+
+@interface CKShardedConcurrentCacheImplTests : XCTestCase
+@end
+
+@implementation CKShardedConcurrentCacheImplTests
+
+- (void)testInsertedItemsCanBeFound
+{
+  ShardedCache cache("test", 0, 0.2);
+  for (int i = 0; i < 100; i++) {
+    cache.insert(i, std::to_string(i), 1);
+  }
+  for (int i = 0; i < 100; i++) {
+    XCTAssertTrue(cache.find(i, "") == std::to_string(i));
+  }
+}
+
+- (void)testMaxCostIsSplitBetweenShards
+{
+  // 8 shards of 2 each; inserting far more than that must evict.
+  ShardedCache cache("test", 16, 0.5);
+  for (int i = 0; i < 1000; i++) {
+    cache.insert(i, std::to_string(i), 1);
+  }
+  int found = 0;
+  for (int i = 0; i < 1000; i++) {
+    if (cache.find(i, "") != "") {
+      found++;
+    }
+  }
+  XCTAssertLessThanOrEqual(found, 16);
+  XCTAssertGreaterThan(found, 0);
+}
+
+- (void)testRemoveAllObjectsEmptiesEveryShard
+{
+  ShardedCache cache("test", 0, 0.2);
+  for (int i = 0; i < 100; i++) {
+    cache.insert(i, std::to_string(i), 1);
+  }
+  cache.removeAllObjects();
+  for (int i = 0; i < 100; i++) {
+    XCTAssertTrue(cache.find(i, "") == "");
+  }
+}
+
+- (void)testSampledTouchStillFindsItems
+{
+  ShardedCache cache("test", 0, 0.2);
+  cache.setTouchSampleRate(4);
+  cache.insert(1, "one", 1);
+  for (int i = 0; i < 10; i++) {
+    XCTAssertTrue(cache.find(1, "") == "one");
+  }
+}
+
+- (void)testConcurrentAccess
+{
+  ShardedCache cache("test", 64, 0.2);
+  cache.setTouchSampleRate(2);
+  ShardedCache *sharedCache = &cache;
+  dispatch_apply(8, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t iteration) {
+    for (int i = 0; i < 1000; i++) {
+      const int key = (int)(i + iteration) % 128;
+      if (sharedCache->find(key, "") == "") {
+        sharedCache->insert(key, std::to_string(key), 1);
+      }
+    }
+  });
+  cache.compact(1);
+  XCTAssertTrue(cache.find(0, "") == "");
+}
+
+@end
+
+@interface CKCacheStatsTests : XCTestCase
+@end
+
+@implementation CKCacheStatsTests
+
+- (void)testHitsMissesAndInsertsAreCounted
+{
+  CK::CacheImpl<int, std::string> cache("test", 0, 0.2);
+  cache.insert(1, "one", 1);
+  cache.insert(2, "two", 1);
+  cache.find(1, "");
+  cache.find(3, "");
+  const CK::CacheStats stats = cache.stats();
+  XCTAssertEqual(stats.inserts, 2u);
+  XCTAssertEqual(stats.hits, 1u);
+  XCTAssertEqual(stats.misses, 1u);
+  XCTAssertEqual(stats.currentCost, 2u);
+}
+
+- (void)testEvictionsAreAttributedToTheirReason
+{
+  CK::CacheImpl<int, std::string> cache("test", 4, 0.5);
+  for (int i = 0; i < 5; i++) {
+    cache.insert(i, std::to_string(i), 1);
+  }
+  XCTAssertEqual(cache.stats().capacityEvictions, 3u);
+  // The peak is taken after the insert compacted the cache, so it never exceeds the maximum cost.
+  XCTAssertEqual(cache.stats().peakCost, 4u);
+
+  cache.compact(1);
+  XCTAssertEqual(cache.stats().compactionEvictions, 2u);
+
+  cache.insert(10, "ten", 1);
+  cache.compact(1, CK::CacheEvictionReason::memoryWarning);
+  XCTAssertEqual(cache.stats().memoryWarningEvictions, 1u);
+  XCTAssertEqual(cache.stats().evictions(), 6u);
+  XCTAssertEqual(cache.stats().currentCost, 0u);
+}
+
+- (void)testEvictionCallbackReceivesEvictedItems
+{
+  CK::CacheImpl<int, std::string> cache("test", 2, 0.5);
+  std::vector<std::pair<int, std::string>> evicted;
+  cache.setEvictionCallback([&](const int &key, const std::string &value, CK::CacheEvictionReason reason) {
+    XCTAssertTrue(reason == CK::CacheEvictionReason::capacity);
+    evicted.push_back({key, value});
+  });
+  cache.insert(1, "one", 1);
+  cache.insert(2, "two", 1);
+  cache.insert(3, "three", 1);
+  XCTAssertEqual(evicted.size(), 2u);
+  XCTAssertTrue(evicted[0] == std::make_pair(1, std::string("one")));
+}
+
+- (void)testShardedStatsIncludeSharedLockLookups
+{
+  ShardedCache cache("test", 0, 0.2);
+  cache.setTouchSampleRate(100);
+  cache.insert(1, "one", 1);
+  for (int i = 0; i < 10; i++) {
+    cache.find(1, "");
+    cache.find(2, "");
+  }
+  XCTAssertEqual(cache.stats().hits, 10u);
+  XCTAssertEqual(cache.stats().misses, 10u);
+}
+
+- (void)testShardedPeakCostNeverExceedsMaxCost
+{
+  ShardedCache cache("test", 16, 0.5);
+  for (int i = 0; i < 100; i++) {
+    cache.insert(i, std::to_string(i), 1);
+  }
+  XCTAssertLessThanOrEqual(cache.stats().peakCost, 16u);
+}
+
+- (void)testShardedItemCostingMoreThanAShardIsNotKept
+{
+  // 8 shards of 2 each: the item fits in the cache as a whole, but not in its shard.
+  ShardedCache cache("test", 16, 0.5);
+  cache.insert(1, "one", 3);
+  XCTAssertEqual(cache.find(1, ""), "");
+  XCTAssertEqual(cache.stats().capacityEvictions, 1u);
+}
+
+@end
+
+#pragma mark - Replay benchmark
+
+/**
+ Replays a key trace against a cache the way the renderer caches are used (find, insert on miss) and returns the hit
+ rate.
+ */
+template <typename CacheT, typename KeyT>
+static double replayHitRate(CacheT &cache, const std::vector<KeyT> &trace)
+{
+  NSUInteger hits = 0;
+  for (const auto &key : trace) {
+    if (cache.find(key, 0) != 0) {
+      hits++;
+    } else {
+      cache.insert(key, 1, 1);
+    }
+  }
+  return trace.empty() ? 0 : (double)hits / trace.size();
+}
+
+template <typename KeyT, typename Hasher>
+static void compareStrategies(const std::vector<KeyT> &trace, NSUInteger capacity, double *lruHitRate, double *l2lruHitRate, double *tinyLFUHitRate)
+{
+  CK::CacheImpl<KeyT, int, Hasher> lru("lru", capacity, 0.1);
+  CK::CacheImpl<KeyT, int, Hasher, CK::EqualFunctor<KeyT>, CK::CacheL2LRUStrategy> l2lru("l2lru", capacity, 0.1, 1, capacity / 2);
+  CK::CacheImpl<KeyT, int, Hasher, CK::EqualFunctor<KeyT>, CK::CacheTinyLFUStrategy> tinyLFU("tinylfu", capacity, 0.1, MAX(capacity / 100, (NSUInteger)1), capacity * 4);
+  *lruHitRate = replayHitRate(lru, trace);
+  *l2lruHitRate = replayHitRate(l2lru, trace);
+  *tinyLFUHitRate = replayHitRate(tinyLFU, trace);
+}
+
+@interface CKCacheReplayBenchmarkTests : XCTestCase
+@end
+
+@implementation CKCacheReplayBenchmarkTests
+
+- (void)testTinyLFUResistsOneOffKeysInFeedLikeTrace
+{
+  // A third of the lookups hit 50 short labels ("Like", "Comment", timestamps...), the rest are one-off post bodies.
+  std::vector<int> trace;
+  srand48(42);
+  int nextOneOffKey = 1000;
+  for (int i = 0; i < 20000; i++) {
+    trace.push_back(drand48() < 0.33 ? (int)(drand48() * 50) + 1 : nextOneOffKey++);
+  }
+
+  double lru, l2lru, tinyLFU;
+  compareStrategies<int, CK::HashFunctor<int>>(trace, 100, &lru, &l2lru, &tinyLFU);
+  NSLog(@"Feed-like trace hit rates: LRU %.3f, L2LRU %.3f, TinyLFU %.3f", lru, l2lru, tinyLFU);
+  XCTAssertGreaterThan(tinyLFU, lru);
+  XCTAssertGreaterThan(tinyLFU, l2lru);
+}
+
+/**
+ Replays a recorded trace, one key per line, from the file at $CK_CACHE_TRACE_PATH. Skipped when it isn't set.
+ Capacity can be overridden with $CK_CACHE_TRACE_CAPACITY (in items).
+ */
+- (void)testReplayRecordedTrace
+{
+  NSDictionary *environment = [[NSProcessInfo processInfo] environment];
+  NSString *path = environment[@"CK_CACHE_TRACE_PATH"];
+  if (!path) {
+    return;
+  }
+  NSString *contents = [NSString stringWithContentsOfFile:path encoding:NSUTF8StringEncoding error:nil];
+  XCTAssertNotNil(contents);
+
+  std::vector<std::string> trace;
+  for (NSString *line in [contents componentsSeparatedByCharactersInSet:[NSCharacterSet newlineCharacterSet]]) {
+    if (line.length > 0) {
+      trace.push_back(line.UTF8String);
+    }
+  }
+  const NSUInteger capacity = environment[@"CK_CACHE_TRACE_CAPACITY"] ? [environment[@"CK_CACHE_TRACE_CAPACITY"] integerValue] : 500;
+
+  double lru, l2lru, tinyLFU;
+  compareStrategies<std::string, std::hash<std::string>>(trace, capacity, &lru, &l2lru, &tinyLFU);
+  NSLog(@"%@ (%lu keys, capacity %lu) hit rates: LRU %.3f, L2LRU %.3f, TinyLFU %.3f",
+        path.lastPathComponent, (unsigned long)trace.size(), (unsigned long)capacity, lru, l2lru, tinyLFU);
+}
+
+@end
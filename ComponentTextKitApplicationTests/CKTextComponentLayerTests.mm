@@ -0,0 +1,82 @@
+/*
+ *  Copyright (c) 2014-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+
+#import <XCTest/XCTest.h>
+
+#import <UIKit/UIKit.h>
+
+#import <ComponentKit/CKTextComponentLayer.h>
+#import <ComponentKit/CKTextKitRenderer.h>
+
+@interface CKTextComponentLayerTests : XCTestCase
+@end
+
+static const CGSize kTextSize = {100, 40};
+
+/** Each test uses its own text, so entries cached by other tests can't be mistaken for prerendered ones. */
+static CKTextKitRenderer *rendererWithText(NSString *text)
+{
+  return [[CKTextKitRenderer alloc] initWithTextKitAttributes:{[[NSAttributedString alloc] initWithString:text]}
+                                              constrainedSize:kTextSize];
+}
+
+/** A layer that displays asynchronously, so its contents are only set right away when they come from the cache. */
+static CKTextComponentLayer *layerWithRenderer(CKTextKitRenderer *renderer)
+{
+  CKTextComponentLayer *layer = [CKTextComponentLayer layer];
+  layer.displayMode = CKAsyncLayerDisplayModeAlwaysAsync;
+  layer.bounds = {CGPointZero, kTextSize};
+  layer.renderer = renderer;
+  return layer;
+}
+
+@implementation CKTextComponentLayerTests
+
+- (void)testPrerenderedRendererIsServedFromTheRasterContentsCacheOnTheNextDisplay
+{
+  [CKTextComponentLayer prerenderRenderer:rendererWithText(@"Prerendered on white")
+                          backgroundColor:[UIColor whiteColor].CGColor
+                                   opaque:YES];
+  CKTextComponentLayer *layer = layerWithRenderer(rendererWithText(@"Prerendered on white"));
+
+  const NSUInteger hits = [CKTextComponentLayer rasterContentsCacheStats].hits;
+  [layer display];
+
+  XCTAssertEqual([CKTextComponentLayer rasterContentsCacheStats].hits, hits + 1);
+  XCTAssertNotNil(layer.contents);
+}
+
+- (void)testPrerenderedRendererIsNotServedToALayerWithAnotherBackgroundColor
+{
+  [CKTextComponentLayer prerenderRenderer:rendererWithText(@"Prerendered on white, shown on red")
+                          backgroundColor:[UIColor whiteColor].CGColor
+                                   opaque:YES];
+  CKTextComponentLayer *layer = layerWithRenderer(rendererWithText(@"Prerendered on white, shown on red"));
+  layer.backgroundColor = [UIColor redColor].CGColor;
+
+  [layer display];
+
+  XCTAssertNil(layer.contents);
+}
+
+- (void)testPrerenderedRendererIsServedToALayerWithTheBackgroundColorItWasPrerenderedWith
+{
+  [CKTextComponentLayer prerenderRenderer:rendererWithText(@"Prerendered on red")
+                          backgroundColor:[UIColor redColor].CGColor
+                                   opaque:YES];
+  CKTextComponentLayer *layer = layerWithRenderer(rendererWithText(@"Prerendered on red"));
+  layer.backgroundColor = [UIColor redColor].CGColor;
+
+  [layer display];
+
+  XCTAssertNotNil(layer.contents);
+}
+
+@end
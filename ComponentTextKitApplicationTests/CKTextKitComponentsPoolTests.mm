@@ -0,0 +1,100 @@
+/*
+ *  Copyright (c) 2014-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+
+#import <XCTest/XCTest.h>
+
+#import <UIKit/UIKit.h>
+
+#import <ComponentKit/CKTextKitComponentsPool.h>
+
+@interface CKTextKitComponentsPoolTests : XCTestCase
+@end
+
+/**
+ Pools refill on a background queue that outlives the test, so the tests leak their pools instead of destroying them
+ under a pending refill.
+ */
+static CKTextKitComponentsPool *poolWithComponents(size_t count)
+{
+  CKTextKitComponentsPool *pool = new CKTextKitComponentsPool();
+  for (size_t i = 0; i < count; i++) {
+    pool->enqueue(CKCreateTextKitComponents(nil, nil));
+  }
+  return pool;
+}
+
+static BOOL waitForPoolSize(CKTextKitComponentsPool *pool, size_t size)
+{
+  NSDate *timeout = [NSDate dateWithTimeIntervalSinceNow:5];
+  while (pool->size() != size && [timeout timeIntervalSinceNow] > 0) {
+    [NSThread sleepForTimeInterval:0.01];
+  }
+  return pool->size() == size;
+}
+
+@implementation CKTextKitComponentsPoolTests
+
+- (void)testStackGivenBackToThePoolComesBackBlank
+{
+  CKTextKitComponentsPool *pool = poolWithComponents(0);
+  CKTextKitComponents components =
+  CKCreateTextKitComponents([[NSAttributedString alloc] initWithString:@"Hello world"], nil);
+  components.textContainer.size = {100, 50};
+  components.textContainer.exclusionPaths = @[[UIBezierPath bezierPathWithRect:{{0, 0}, {10, 10}}]];
+  components.textContainer.lineBreakMode = NSLineBreakByTruncatingTail;
+  components.textContainer.maximumNumberOfLines = 2;
+
+  pool->enqueue(components);
+  CKTextKitComponents dequeued = {};
+  XCTAssertTrue(pool->dequeue(dequeued));
+
+  XCTAssertEqual(dequeued.textStorage, components.textStorage);
+  XCTAssertEqual(dequeued.textStorage.length, 0u);
+  XCTAssertTrue(CGSizeEqualToSize(dequeued.textContainer.size, CGSizeZero));
+  XCTAssertEqual(dequeued.textContainer.exclusionPaths.count, 0u);
+  XCTAssertEqual(dequeued.textContainer.lineBreakMode, NSLineBreakByWordWrapping);
+  XCTAssertEqual(dequeued.textContainer.maximumNumberOfLines, 0u);
+}
+
+- (void)testPoolDropsStacksGivenBackBeyondItsMaximumSize
+{
+  const size_t maximumSize = CKTextKitComponentsPool::kMaximumSize;
+  CKTextKitComponentsPool *pool = poolWithComponents(maximumSize + 4);
+  XCTAssertEqual(pool->size(), maximumSize);
+}
+
+- (void)testDequeuingFromAnEmptyPoolFailsAndRefillsThePool
+{
+  const size_t refillTarget = CKTextKitComponentsPool::kRefillTarget;
+  CKTextKitComponentsPool *pool = poolWithComponents(0);
+  CKTextKitComponents components = {};
+  XCTAssertFalse(pool->dequeue(components));
+  XCTAssertTrue(waitForPoolSize(pool, refillTarget));
+  // The refill stops at its target.
+  [NSThread sleepForTimeInterval:0.1];
+  XCTAssertEqual(pool->size(), refillTarget);
+}
+
+- (void)testPoolOnlyRefillsOnceItDropsBelowTheRefillThreshold
+{
+  const size_t refillThreshold = CKTextKitComponentsPool::kRefillThreshold;
+  const size_t refillTarget = CKTextKitComponentsPool::kRefillTarget;
+  CKTextKitComponentsPool *pool = poolWithComponents(refillThreshold + 1);
+  CKTextKitComponents components = {};
+
+  XCTAssertTrue(pool->dequeue(components));
+  [NSThread sleepForTimeInterval:0.1];
+  XCTAssertEqual(pool->size(), refillThreshold);
+
+  XCTAssertTrue(pool->dequeue(components));
+  XCTAssertTrue(waitForPoolSize(pool, refillTarget));
+}
+
+@end
@@ -17,6 +17,8 @@
 #import <ComponentKit/CKTextKitAttributes.h>
 #import <ComponentKit/CKTextKitRenderer.h>
 #import <ComponentKit/CKTextKitRenderer+Positioning.h>
+#import <ComponentKit/CKTextKitShapedTextCache.h>
+#import <ComponentKit/CKTextComponentLayer.h>
 
 @interface CKTextKitTests : XCTestCase
 
@@ -155,4 +157,107 @@ static BOOL checkAttributes(const CKTextKitAttributes &attributes, const CGSize
   XCTAssert([renderer rectsForTextRange:NSMakeRange(0, attributedString.length) measureOption:CKTextKitRendererMeasureOptionBlock].count > 0);
 }
 
+- (void)testEstimatedCostGrowsWithTextLength
+{
+  NSDictionary *attributes = @{NSFontAttributeName : [UIFont systemFontOfSize:12]};
+  NSMutableString *longString = [NSMutableString string];
+  for (int i = 0; i < 100; i++) {
+    [longString appendString:@"Plaid wayfarers Odd Future master cleanse. "];
+  }
+  CKTextKitRenderer *shortRenderer =
+  [[CKTextKitRenderer alloc]
+   initWithTextKitAttributes:{.attributedString = [[NSAttributedString alloc] initWithString:@"Like" attributes:attributes]}
+   constrainedSize:{ 320, CGFLOAT_MAX }];
+  CKTextKitRenderer *longRenderer =
+  [[CKTextKitRenderer alloc]
+   initWithTextKitAttributes:{.attributedString = [[NSAttributedString alloc] initWithString:longString attributes:attributes]}
+   constrainedSize:{ 320, CGFLOAT_MAX }];
+
+  XCTAssertGreaterThan(shortRenderer.estimatedCost, 0u);
+  XCTAssertGreaterThan(longRenderer.estimatedCost, 5 * shortRenderer.estimatedCost);
+}
+
+- (void)testShapedTextMeasurementMatchesRendererAcrossWidths
+{
+  CKTextKitAttributes attributes {
+    .attributedString = [[NSAttributedString alloc] initWithString:@"90's cray photo booth tote bag bespoke Carles. Plaid wayfarers Odd Future master cleanse tattooed four dollar toast." attributes:@{NSFontAttributeName : [UIFont systemFontOfSize:12]}],
+    .shadowOffset = {1, 2},
+    .shadowOpacity = 0.5,
+    .shadowRadius = 2,
+  };
+  for (CGFloat width : {320.0, 200.0, 123.0, 320.0}) {
+    const CGSize constrainedSize = {width, CGFLOAT_MAX};
+    CKTextKitRenderer *renderer = [[CKTextKitRenderer alloc] initWithTextKitAttributes:attributes constrainedSize:constrainedSize];
+    CGSize shapedSize;
+    CGFloat shapedBaseline;
+    XCTAssertTrue(CK::TextKit::ShapedText::measure(attributes, constrainedSize, &shapedSize, &shapedBaseline));
+    XCTAssertTrue(CGSizeEqualToSize(shapedSize, renderer.size));
+    XCTAssertEqual(shapedBaseline, renderer.baseline);
+  }
+}
+
+- (void)testShapedTextMeasurementDeclinesWhenTextWouldBeTruncated
+{
+  CKTextKitAttributes attributes {
+    .attributedString = [[NSAttributedString alloc] initWithString:@"90's cray photo booth tote bag bespoke Carles. Plaid wayfarers Odd Future master cleanse tattooed four dollar toast." attributes:@{NSFontAttributeName : [UIFont systemFontOfSize:12]}],
+    .truncationAttributedString = [[NSAttributedString alloc] initWithString:@"\u2026"],
+    .maximumNumberOfLines = 1,
+  };
+  CGSize shapedSize;
+  XCTAssertFalse(CK::TextKit::ShapedText::measure(attributes, {100, CGFLOAT_MAX}, &shapedSize));
+}
+
+- (void)testTiledLayerOnlyDrawsTilesNearTheVisibleRect
+{
+  NSMutableString *longString = [NSMutableString string];
+  for (int i = 0; i < 200; i++) {
+    [longString appendString:@"Plaid wayfarers Odd Future master cleanse. "];
+  }
+  const CGSize constrainedSize = {320, 2000};
+  CKTextKitRenderer *renderer =
+  [[CKTextKitRenderer alloc]
+   initWithTextKitAttributes:{.attributedString = [[NSAttributedString alloc] initWithString:longString attributes:@{NSFontAttributeName : [UIFont systemFontOfSize:12]}]}
+   constrainedSize:constrainedSize];
+
+  CKTextComponentLayer *layer = [CKTextComponentLayer layer];
+  layer.displayMode = CKAsyncLayerDisplayModeAlwaysSync;
+  layer.tileHeight = 256;
+  layer.bounds = {.size = constrainedSize};
+  layer.renderer = renderer;
+  [layer displayIfNeeded];
+
+  // Outside of a layer tree only the top tile and its lookahead are drawn.
+  XCTAssertNil(layer.contents);
+  XCTAssertEqual(layer.sublayers.count, 2u);
+  for (CALayer *tile in layer.sublayers) {
+    XCTAssertNotNil(tile.contents);
+    XCTAssertEqual(CGRectGetHeight(tile.frame), 256);
+  }
+}
+
+- (void)testRendererMeasuresLinesBaselineAndTruncationUpFront
+{
+  UIFont *font = [UIFont systemFontOfSize:12];
+  NSAttributedString *string = [[NSAttributedString alloc] initWithString:@"90's cray photo booth tote bag bespoke Carles. Plaid wayfarers Odd Future master cleanse tattooed four dollar toast." attributes:@{NSFontAttributeName : font}];
+  CKTextKitRenderer *fullRenderer =
+  [[CKTextKitRenderer alloc]
+   initWithTextKitAttributes:{.attributedString = string}
+   constrainedSize:{ 100, CGFLOAT_MAX }];
+  CKTextKitRenderer *truncatedRenderer =
+  [[CKTextKitRenderer alloc]
+   initWithTextKitAttributes:{
+     .attributedString = string,
+     .truncationAttributedString = [[NSAttributedString alloc] initWithString:@"\u2026"],
+     .maximumNumberOfLines = 1,
+   }
+   constrainedSize:{ 100, CGFLOAT_MAX }];
+
+  XCTAssertGreaterThan(fullRenderer.lineCount, 1u);
+  XCTAssertFalse(fullRenderer.isTruncated);
+  XCTAssertEqual(truncatedRenderer.lineCount, 1u);
+  XCTAssertTrue(truncatedRenderer.isTruncated);
+  XCTAssertEqualWithAccuracy(fullRenderer.baseline, font.ascender, 1);
+  XCTAssertEqual(fullRenderer.baseline, truncatedRenderer.baseline);
+}
+
 @end
@@ -166,4 +166,33 @@
   XCTAssertEqual(renderer.lineCount, maximumNumberOfLines);
 }
 
+- (void)testMixedDirectionTailTruncationKeepsTruncationMessageVisible
+{
+  CGSize constrainedSize = CGSizeMake(100, 50);
+  // No paragraph style: the writing direction is natural, and the last line mixes LTR and RTL runs
+  NSAttributedString *attributedString =
+  [[NSAttributedString alloc] initWithString:@"Photo booth שלום עולם tote bag bespoke כל הכבוד Carles wayfarers מה שלומך kale chips leggings"
+                                  attributes:@{}];
+  CKTextKitContext *context = [[CKTextKitContext alloc] initWithAttributedString:attributedString
+                                                                   lineBreakMode:NSLineBreakByWordWrapping
+                                                            maximumNumberOfLines:0
+                                                                 constrainedSize:constrainedSize
+                                                            layoutManagerFactory:nil];
+  CKTextKitTailTruncater *tailTruncater = [[CKTextKitTailTruncater alloc] initWithContext:context
+                                                               truncationAttributedString:[self _simpleTruncationAttributedString]
+                                                                   avoidTailTruncationSet:[NSCharacterSet characterSetWithCharactersInString:@""]
+                                                                          constrainedSize:constrainedSize];
+  (void)tailTruncater;
+  __block NSString *drawnString;
+  __block NSRange laidOutCharacterRange;
+  [context performBlockWithLockedTextKitComponents:^(NSLayoutManager *layoutManager, NSTextStorage *textStorage, NSTextContainer *textContainer) {
+    drawnString = textStorage.string;
+    laidOutCharacterRange = [layoutManager characterRangeForGlyphRange:[layoutManager glyphRangeForTextContainer:textContainer]
+                                                      actualGlyphRange:NULL];
+  }];
+  XCTAssertTrue([drawnString hasSuffix:@"..."]);
+  // Clipping the wrong glyph would leave text that pushes the truncation message out of the container
+  XCTAssertEqual(laidOutCharacterRange.length, drawnString.length);
+}
+
 @end